@@ -25,7 +25,8 @@
  * PS. Instead of Watson's method you may choose to link with the triangulate2
  * routine written by Jonathan Shewchuk.  See the file TRIANGLE.HOWTO for
  * details.  That function is far faster than Watson's method and also allows
- * for Voronoi polygon output.
+ * for Voronoi polygon output.  Finally, -Ti selects the built-in incremental
+ * engine below, which needs neither and scales to very large point sets.
  *
  * Author:	Paul Wessel modified by Samantha Zambo
  * Date:	1-JAN-2010
@@ -39,70 +40,2879 @@
 
 #include "gmt_dev.h"		/* Must include this to use GMT DEV API */
 #include "custom_version.h"	/* Must include this to use Custom_version */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRIANGULATE2_X86_SIMD	/* Build the AVX2 and AVX-512 kernels and pick one at run time */
+#include <immintrin.h>
+#endif
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#define GMT_PROG_OPTIONS "-:>JRVbdfhirs" GMT_ADD_x_OPT GMT_OPT("FHm")
+//#define GMT_PROG_OPTIONS "-:>RVabfghior" "H"	/* The H is for possible compatibility with GMT4 syntax */
+
+static double EPS_D = 2.220446e-16;
+
+enum triangulate2_product {	/* The kinds of grid -G can write */
+	TRIANGULATE2_Z = 0,	/* Planar z */
+	TRIANGULATE2_DZDX,	/* Plane slope in x */
+	TRIANGULATE2_DZDY,	/* Plane slope in y */
+	TRIANGULATE2_SIGMA,	/* CURVE uncertainty */
+	TRIANGULATE2_N_PRODUCTS
+};
+
+#define TRIANGULATE2_GRID(kind,b,n_z)	((kind) * (n_z) + (b))	/* Index of the grid of one kind for z column b */
+#ifdef _OPENMP
+#define TRIANGULATE2_THREADS(GMT)	MAX ((GMT)->common.x.n_threads, 1)	/* Threads to use (-x), at least one */
+#else
+#define TRIANGULATE2_THREADS(GMT)	1
+#endif
+
+struct TRIANGULATE2_CTRL {
+	struct A {	/* -A[b|m|r][+n<rows>][+s[h|m]] */
+		bool active;
+		unsigned int mode;
+		unsigned int sort;	/* Space-filling curve to order the points along (0 if none) */
+		uint64_t n_rows;	/* Expected number of records (0 if unknown) */
+	} A;
+	struct C {	/* -C<queryfile>|+s|+u<socket> */
+		bool active;
+		bool serve;	/* Answer batches of queries from standard input or a socket until told to quit */
+		char *file;
+		char *socket;
+	} C;
+	struct D {	/* -Dx|y */
+		bool active;
+		unsigned int dir;
+	} D;
+	struct E {	/* -E<value> */
+		bool active;
+		double value;
+	} E;
+	struct G {	/* -G<output_grdfile>[+x<dzdx>][+y<dzdy>][+z<z>][+u<sigma>][+t<rows>] */
+		bool active;
+		unsigned int tile;	/* Rows per tile when writing the grids a tile at a time (0 for all at once) */
+		char *file;
+		char *product[TRIANGULATE2_N_PRODUCTS];	/* Output file for each kind of grid, or NULL */
+	} G;
+	struct I {	/* -Idx[/dy] */
+		bool active;
+		double inc[2];
+	} I;
+	struct L {	/* -L<tinfile>[+w] */
+		bool active;
+		bool write;	/* Save the triangulation rather than load it */
+		char *file;
+	} L;
+	struct M {	/* -M */
+		bool active;
+	} M;
+	struct N {	/* -N[+n] */
+		bool active;
+		bool neighbors;	/* Also write the neighbor triangles */
+	} N;
+	struct Q {	/* -Q */
+		bool active;
+	} Q;
+	struct S {	/* -S */
+		bool active;
+	} S;
+	struct T {	/* -Tg|i|p */
+		bool active;
+		unsigned int mode;
+	} T;
+	struct W {	/* -W<weightfile>[+w] */
+		bool active;
+		bool write;	/* Save the node weights rather than load them */
+		char *file;
+	} W;
+	//CURVE
+	struct u {	/* -u<input_Slopes>[+a<alpha>][+d<delta_min>][+h<s_H>] */
+		bool active;
+		char *file;
+		double alpha;		/* Exponent of the distance term */
+		double delta_min;	/* Distance scale [x increment] */
+		double s_H;		/* Scale of the horizontal uncertainty added to the distance */
+	} u;
+	struct Z {	/* -Z[<nz>] */
+		bool active;
+		unsigned int n_z;	/* Number of z columns [1] */
+	} Z;
+};
+
+GMT_LOCAL int compare_vertex (const void *p1, const void *p2) {
+	const uint64_t *a = p1, *b = p2;
+
+	if (*a < *b) return (-1);
+	if (*a > *b) return (+1);
+	return (0);
+}
+
+enum curve_enum {	/* Indices for coeff array for normalization */
+	GMT_H = GMT_Z + 1	,	/* Index into input/output rows */
+	GMT_V,
+	GMT_U = GMT_H
+};
+
+#define TRIANGULATE2_MAX_Z	256	/* Most z columns (e.g., epochs) gridded in one pass (-Z<nz>) */
+#define TRIANGULATE2_N_COLS	(GMT_V + TRIANGULATE2_MAX_Z)	/* x, y, z, h, v and the other z columns */
+#define TRIANGULATE2_ZCOL(b)	((b) ? GMT_V + (b) : GMT_Z)	/* Where z column b is kept */
+
+enum triangulate2_read {	/* How the input table is ingested (-A) */
+	TRIANGULATE2_READ_AUTO = 0,	/* Parse a plain ASCII file with all threads, else as RECORD [Default] */
+	TRIANGULATE2_READ_RECORD,	/* One record at a time via GMT_Get_Record */
+	TRIANGULATE2_READ_BULK,		/* The whole dataset at once via GMT_Read_Data */
+	TRIANGULATE2_READ_MMAP		/* Memory-map a native binary file */
+};
+
+enum triangulate2_sort {	/* Space-filling curves for ordering the points (-A+s) */
+	TRIANGULATE2_SORT_NONE = 0,
+	TRIANGULATE2_SORT_HILBERT,
+	TRIANGULATE2_SORT_MORTON
+};
+
+#define TRIANGULATE2_CURVE_BITS	16	/* Bits per coordinate when placing points on the curves */
+
+enum triangulate2_engine {	/* Who triangulates the points (-T) */
+	TRIANGULATE2_ENGINE_GMT = 0,	/* gmt_delaunay, i.e. Watson or Shewchuk per GMT_TRIANGULATE [Default] */
+	TRIANGULATE2_ENGINE_BUILTIN,	/* Our incremental Bowyer-Watson engine */
+	TRIANGULATE2_ENGINE_PARALLEL	/* The same, on slabs of points in parallel */
+};
+
+struct TRIANGULATE2_INPUT {	/* The input points as one (possibly strided) array per column */
+	uint64_t n;				/* Number of points */
+	uint64_t inc;				/* Distance between consecutive values in a column [1] */
+	unsigned int n_z;			/* Number of z columns to read */
+	double *col[TRIANGULATE2_N_COLS];	/* x, y, z, h, v and other z arrays (NULL if not read) */
+	double *arena;				/* If not NULL all columns live in this one allocation */
+	struct GMT_DATASET *D;			/* If not NULL the columns point into this dataset */
+	void *map;				/* If not NULL the columns point into this memory-mapped file */
+	size_t map_size;			/* Length of the mapping in bytes */
+	uint64_t *id;				/* If not NULL the points were reordered and this is their input record number */
+};
+
+struct TRIANGULATE2_TIN_HEADER {	/* Start of a binary TIN file (-L) */
+	char magic[8];			/* TRIANGULATE2_TIN_MAGIC */
+	uint64_t n_points;		/* Number of vertices */
+	uint64_t n_triangles;		/* Number of triangles */
+	uint64_t flags;			/* TRIANGULATE2_TIN_* bits for the optional sections present */
+	double wesn[4];			/* Bounding box of the vertices */
+};
+/* The header is followed by x[n_points] and y[n_points] as doubles, link[3*n_triangles] as uint64_t
+ * vertex indices (counter-clockwise for the built-in engines) and, if flagged, neighbor[3*n_triangles]
+ * as uint64_t triangle numbers, neighbor[3*t+k] sharing the edge from vertex k to k+1 of triangle t,
+ * with UINT64_MAX across the hull.  All in native byte order so the file can be mapped. */
+
+#define TRIANGULATE2_TIN_MAGIC		"GMTTIN1"
+#define TRIANGULATE2_TIN_NEIGHBORS	1U	/* A neighbor table follows the triangles */
+
+struct TRIANGULATE2_TIN {	/* A TIN file in memory */
+	struct TRIANGULATE2_TIN_HEADER *H;
+	double *x, *y;			/* Vertices */
+	uint64_t *link;			/* Triangles */
+	uint64_t *neighbor;		/* Neighbors or NULL */
+	void *map;			/* The whole file, mapped or read */
+	size_t size;			/* Its size in bytes */
+};
+
+struct TRIANGULATE2_WEIGHT_HEADER {	/* Start of a binary weight file (-W) */
+	char magic[8];			/* TRIANGULATE2_WEIGHT_MAGIC */
+	uint64_t n_points;		/* Number of vertices */
+	uint64_t n_triangles;		/* Number of triangles */
+	uint64_t n_nodes;		/* Number of grid nodes inside a triangle */
+	uint32_t n_columns, n_rows;	/* Dimensions of the grid */
+	uint32_t registration;		/* Its registration */
+	uint32_t unused;
+	double wesn[4], inc[2];		/* Its region and increments */
+};
+/* The header is followed by x[n_points] and y[n_points] as doubles, link[3*n_triangles] as uint64_t
+ * vertex indices, and one TRIANGULATE2_WEIGHT per node, in grid order.  Native byte order. */
+
+#define TRIANGULATE2_WEIGHT_MAGIC	"GMTBWC1"
+
+struct TRIANGULATE2_WEIGHT {	/* A grid node and where it sits in its triangle */
+	uint64_t node;			/* row * n_columns + col */
+	uint64_t tri;			/* Triangle in link */
+	float w[3];			/* Barycentric weights of its three vertices */
+	uint32_t unused;
+};
+
+struct TRIANGULATE2_WEIGHTS {	/* A weight file in memory */
+	struct TRIANGULATE2_WEIGHT_HEADER *H;
+	double *x, *y;			/* Vertices */
+	uint64_t *link;			/* Triangles */
+	struct TRIANGULATE2_WEIGHT *weight;	/* The nodes */
+	void *map;			/* The whole file, mapped or read */
+	size_t size;			/* Its size in bytes */
+};
+
+GMT_LOCAL void unmap_file (struct GMT_CTRL *GMT, void *map, size_t size) {
+	/* Release a file loaded by map_file */
+#ifndef WIN32
+	gmt_M_unused (GMT);
+	munmap (map, size);
+#else
+	gmt_M_unused (size);
+	gmt_M_free (GMT, map);
+#endif
+}
+
+GMT_LOCAL void free_tin (struct GMT_CTRL *GMT, struct TRIANGULATE2_TIN *Tin) {
+	if (!Tin->map) return;
+	unmap_file (GMT, Tin->map, Tin->size);
+	gmt_M_memset (Tin, 1, struct TRIANGULATE2_TIN);
+}
+
+GMT_LOCAL void free_weights (struct GMT_CTRL *GMT, struct TRIANGULATE2_WEIGHTS *W) {
+	if (!W->map) return;
+	unmap_file (GMT, W->map, W->size);
+	gmt_M_memset (W, 1, struct TRIANGULATE2_WEIGHTS);
+}
+
+GMT_LOCAL void set_input_columns (unsigned int n_input, unsigned int n_z, int src[]) {
+	/* Determine which input column supplies x, y, each z, h, v (-1 if not read).  The records
+	 * are x,y, then the n_z z columns, then h,v if there is room for them.  Note that x,y,h,v
+	 * records (no z) take h,v from columns 2-3; the old loop read in[GMT_H], in[GMT_V] there,
+	 * which is one column past the end of the record. */
+	unsigned int k;
+
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) src[k] = -1;
+	src[GMT_X] = GMT_X;	src[GMT_Y] = GMT_Y;
+	for (k = 0; k < n_z; k++) src[TRIANGULATE2_ZCOL (k)] = GMT_Z + k;
+	if (n_input == n_z + 4) {	/* CURVE: x,y,[z...],h,v */
+		src[GMT_H] = GMT_Z + n_z;	src[GMT_V] = GMT_H + n_z;
+	}
+}
+
+GMT_LOCAL void alloc_columns (struct GMT_CTRL *GMT, struct TRIANGULATE2_INPUT *In, int src[], uint64_t n_alloc) {
+	/* Carve all the columns we read out of a single allocation with room for n_alloc rows each */
+	unsigned int k, slot = 0;
+
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) slot++;
+	In->arena = gmt_M_memory (GMT, NULL, slot * n_alloc, double);
+	for (k = slot = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) In->col[k] = In->arena + (slot++) * n_alloc;
+}
+
+GMT_LOCAL void resize_columns (struct GMT_CTRL *GMT, struct TRIANGULATE2_INPUT *In, uint64_t n_old, uint64_t n_new) {
+	/* Change the room per column in the arena from n_old to n_new rows, keeping the first In->n values.
+	 * When growing the columns are moved up last-first after the realloc; when shrinking they are moved
+	 * down first-last before it, so no column overwrites one that has not been moved yet. */
+	unsigned int k, slot, n_slots = 0, order[TRIANGULATE2_N_COLS];
+
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (In->col[k]) order[n_slots++] = k;
+	if (n_new > n_old) {
+		In->arena = gmt_M_memory (GMT, In->arena, n_slots * n_new, double);
+		for (slot = n_slots; slot > 1; slot--) memmove (In->arena + (slot-1) * n_new, In->arena + (slot-1) * n_old, In->n * sizeof (double));
+	}
+	else {
+		for (slot = 1; slot < n_slots; slot++) memmove (In->arena + slot * n_new, In->arena + slot * n_old, In->n * sizeof (double));
+		In->arena = gmt_M_memory (GMT, In->arena, n_slots * n_new, double);
+	}
+	for (slot = 0; slot < n_slots; slot++) In->col[order[slot]] = In->arena + slot * n_new;
+}
+
+GMT_LOCAL size_t binary_record_size (struct GMT_CTRL *GMT, unsigned int n_input) {
+	/* Bytes per record of binary input, assuming all columns have the -bi data type */
+	uint64_t n_cols = GMT->common.b.ncol[GMT_IN];
+	size_t width;
+
+	switch (GMT->common.b.type[GMT_IN]) {
+		case 'c': case 'u': width = 1; break;
+		case 'h': case 'H': width = 2; break;
+		case 'i': case 'I': case 'f': width = 4; break;
+		default: width = 8; break;	/* l, L, d */
+	}
+	if (n_cols < n_input) n_cols = n_input;
+	return (n_cols * width);
+}
+
+#define TRIANGULATE2_COUNT_BYTES	(16 * 1024 * 1024)	/* Count newlines in this much of an ASCII file, then extrapolate */
+
+GMT_LOCAL uint64_t estimate_records (struct GMT_CTRL *GMT, struct GMT_OPTION *options, unsigned int n_input) {
+	/* Guess how many records the input files hold so the columns can be allocated once: binary
+	 * files from their size and record length, ASCII files by counting newlines (headers included)
+	 * in the first TRIANGULATE2_COUNT_BYTES and scaling up by the file size, with a little to spare.
+	 * Should that still be short the reader just grows the columns.  Returns 0 if we cannot tell,
+	 * e.g. when reading stdin. */
+	uint64_t n = 0, n_lines;
+	size_t n_read, n_bytes, rec_size = 0;
+	char *buffer = NULL, *c = NULL;
+	bool binary = GMT->common.b.active[GMT_IN];
+	FILE *fp = NULL;
+	struct stat buf;
+	struct GMT_OPTION *opt = NULL;
+
+	if (binary) rec_size = binary_record_size (GMT, n_input);
+	for (opt = options; opt; opt = opt->next) {
+		if (opt->option != GMT_OPT_INFILE) continue;
+		if (stat (opt->arg, &buf) || !S_ISREG (buf.st_mode)) {	/* Cannot tell for URLs, pipes, etc. */
+			gmt_M_free (GMT, buffer);
+			return (0);
+		}
+		if (binary) {
+			n += buf.st_size / rec_size;
+			continue;
+		}
+		if ((fp = fopen (opt->arg, "rb")) == NULL) continue;	/* Let the reader report the problem */
+		if (!buffer) buffer = gmt_M_memory (GMT, NULL, GMT_BUFSIZ * 256, char);
+		n_lines = n_bytes = 0;
+		while (n_bytes < TRIANGULATE2_COUNT_BYTES && (n_read = fread (buffer, 1, GMT_BUFSIZ * 256, fp)) > 0) {
+			for (c = buffer; (c = memchr (c, '\n', n_read - (c - buffer))) != NULL; c++) n_lines++;
+			n_bytes += n_read;
+		}
+		if (n_bytes < (size_t)buf.st_size)	/* Only counted the start of a large file */
+			n_lines = (uint64_t)(1.05 * n_lines * ((double)buf.st_size / n_bytes));
+		n += n_lines + 1;	/* In case the last line has no newline */
+		fclose (fp);
+	}
+	gmt_M_free (GMT, buffer);
+	return (n);
+}
+
+GMT_LOCAL void free_input (struct GMT_CTRL *GMT, struct TRIANGULATE2_INPUT *In) {
+	/* Release the input columns, whether we allocated them or they belong to a dataset or mapped file */
+	unsigned int k;
+
+	if (In->D) {	/* Columns were pointers into the dataset */
+		GMT_Destroy_Data (GMT->parent, &In->D);
+		for (k = 0; k < TRIANGULATE2_N_COLS; k++) In->col[k] = NULL;
+	}
+#ifndef WIN32
+	else if (In->map) {	/* Columns were pointers into the mapped file */
+		munmap (In->map, In->map_size);
+		In->map = NULL;
+		for (k = 0; k < TRIANGULATE2_N_COLS; k++) In->col[k] = NULL;
+	}
+#endif
+	else {
+		gmt_M_free (GMT, In->arena);
+		for (k = 0; k < TRIANGULATE2_N_COLS; k++) In->col[k] = NULL;
+	}
+	gmt_M_free (GMT, In->id);
+	In->n = 0;
+}
+
+GMT_LOCAL int read_records (struct GMT_CTRL *GMT, struct GMT_OPTION *options, unsigned int n_input, uint64_t n_rows, struct TRIANGULATE2_INPUT *In) {
+	/* Read the input one record at a time.  The columns are sized once from n_rows if given,
+	 * else from what the input files suggest, and only grow if that turns out to be too small. */
+	int src[TRIANGULATE2_N_COLS];
+	unsigned int k;
+	uint64_t n = 0, n_alloc = n_rows;
+	double *in = NULL;
+	struct GMTAPI_CTRL *API = GMT->parent;
+
+	if (GMT_Begin_IO (API, GMT_IS_DATASET, GMT_IN, GMT_HEADER_ON) != GMT_NOERROR)	/* Enables data input and sets access mode */
+		return (API->error);
+
+	if (n_alloc == 0 && (n_alloc = estimate_records (GMT, options, n_input)) > 0)
+		GMT_Report (API, GMT_MSG_LONG_VERBOSE, "Expecting about %" PRIu64 " input records\n", n_alloc);
+	if (n_alloc == 0) n_alloc = GMT_INITIAL_MEM_ROW_ALLOC;
+	set_input_columns (n_input, In->n_z, src);
+	alloc_columns (GMT, In, src, n_alloc);
+
+	do {	/* Keep returning records until we reach EOF */
+		if ((in = GMT_Get_Record (API, GMT_READ_DOUBLE, NULL)) == NULL) {	/* Read next record, get NULL if special case */
+			if (gmt_M_rec_is_error (GMT)) {		/* Bail if there are any read errors */
+				free_input (GMT, In);
+				return (GMT_RUNTIME_ERROR);
+			}
+			if (gmt_M_rec_is_any_header (GMT)) 	/* Skip all headers */
+				continue;
+			if (gmt_M_rec_is_eof (GMT)) 		/* Reached end of file */
+				break;
+		}
+
+		/* Data record to process */
+
+		In->col[GMT_X][n] = in[GMT_X];	In->col[GMT_Y][n] = in[GMT_Y];
+		if (src[GMT_Z] >= 0) In->col[GMT_Z][n] = in[src[GMT_Z]];
+		for (k = 1; k < In->n_z; k++) In->col[TRIANGULATE2_ZCOL (k)][n] = in[src[TRIANGULATE2_ZCOL (k)]];
+		if (src[GMT_H] >= 0) {	//CURVE
+			In->col[GMT_H][n] = in[src[GMT_H]];
+			In->col[GMT_V][n] = in[src[GMT_V]];
+		}
+		In->n = ++n;
+
+		if (n == n_alloc) {	/* Get more memory */
+			resize_columns (GMT, In, n_alloc, n_alloc << 1);
+			n_alloc <<= 1;
+		}
+	} while (true);
+
+	if (GMT_End_IO (API, GMT_IN, 0) != GMT_NOERROR) {	/* Disables further data input */
+		free_input (GMT, In);
+		return (API->error);
+	}
+
+	if (n && n < n_alloc) resize_columns (GMT, In, n_alloc, n);	/* Give back the unused room */
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int read_dataset (struct GMT_CTRL *GMT, unsigned int n_input, struct TRIANGULATE2_INPUT *In) {
+	/* Read the entire input table in one go.  A single segment is used in place: the
+	 * columns simply point into the dataset.  Otherwise the segments are concatenated
+	 * with one memcpy per column and segment and the dataset is released. */
+	int src[TRIANGULATE2_N_COLS];
+	unsigned int k;
+	uint64_t tbl, seg, n = 0;
+	struct GMT_DATASET *D = NULL;
+	struct GMT_DATASEGMENT *S = NULL;
+	struct GMTAPI_CTRL *API = GMT->parent;
+
+	if ((D = GMT_Read_Data (API, GMT_IS_DATASET, GMT_IS_FILE, GMT_IS_POINT, GMT_READ_NORMAL, NULL, NULL, NULL)) == NULL)
+		return (API->error);
+	if (D->n_records && D->n_columns < n_input) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Input data have %d column(s) but at least %u are needed\n", (int)D->n_columns, n_input);
+		GMT_Destroy_Data (API, &D);
+		return (GMT_DIM_TOO_SMALL);
+	}
+
+	set_input_columns (n_input, In->n_z, src);
+	if (D->n_tables == 1 && D->table[0]->n_segments == 1) {	/* Use the columns as they are */
+		S = D->table[0]->segment[0];
+		for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) In->col[k] = S->coord[src[k]];
+		n = S->n_rows;
+		In->D = D;
+	}
+	else {	/* Must concatenate the segments */
+		alloc_columns (GMT, In, src, D->n_records);
+		for (tbl = 0; tbl < D->n_tables; tbl++) {
+			for (seg = 0; seg < D->table[tbl]->n_segments; seg++) {
+				S = D->table[tbl]->segment[seg];
+				for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) gmt_M_memcpy (&In->col[k][n], S->coord[src[k]], S->n_rows, double);
+				n += S->n_rows;
+			}
+		}
+		GMT_Destroy_Data (API, &D);
+	}
+	In->n = n;
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int map_binary (struct GMT_CTRL *GMT, struct GMT_OPTION *options, unsigned int n_input, struct TRIANGULATE2_INPUT *In) {
+	/* Memory-map a single native binary file of double precision records and let the columns be
+	 * strided views into the mapping so nothing is copied or held twice in memory.  If the input
+	 * does not qualify we leave In->map NULL and the caller reads the input the usual way. */
+	unsigned int n_files = 0;
+	char *file = NULL;
+	struct GMT_OPTION *opt = NULL;
+	struct GMTAPI_CTRL *API = GMT->parent;
+#ifndef WIN32
+	int fd, src[TRIANGULATE2_N_COLS];
+	unsigned int k;
+	uint64_t n_cols, row, n;
+	size_t rec_size;
+	double *base = NULL;
+	struct stat buf;
+#endif
+
+	for (opt = options; opt; opt = opt->next) if (opt->option == GMT_OPT_INFILE) file = opt->arg, n_files++;
+#ifdef WIN32
+	GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: Memory-mapped input is not available under Windows; reading records instead\n");
+	return (GMT_NOERROR);
+#else
+	if (n_files != 1) {
+		GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: Memory-mapping requires a single input file; reading records instead\n");
+		return (GMT_NOERROR);
+	}
+	if (!GMT->common.b.active[GMT_IN] || GMT->common.b.type[GMT_IN] != 'd' || GMT->common.b.swab[GMT_IN]) {
+		GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: Memory-mapping requires native double precision binary input (-bi<n>d); reading records instead\n");
+		return (GMT_NOERROR);
+	}
+	if (GMT->common.i.active || GMT->current.setting.io_lonlat_toggle[GMT_IN] || GMT->current.setting.io_header[GMT_IN] || GMT->common.d.active[GMT_IN] || GMT->common.s.active) {
+		GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: Memory-mapping cannot be combined with -:, -d, -h, -i or -s; reading records instead\n");
+		return (GMT_NOERROR);
+	}
+	rec_size = binary_record_size (GMT, n_input);
+	n_cols = rec_size / sizeof (double);
+	if (stat (file, &buf) || !S_ISREG (buf.st_mode) || buf.st_size == 0 || buf.st_size % rec_size) {
+		GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: %s is not a regular file of %" PRIu64 "-column records; reading records instead\n", file, n_cols);
+		return (GMT_NOERROR);
+	}
+	n = buf.st_size / rec_size;
+	if ((fd = open (file, O_RDONLY)) < 0) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Cannot open file %s\n", file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	In->map = mmap (NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (In->map == MAP_FAILED) {
+		GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: Unable to memory-map %s (%s); reading records instead\n", file, strerror (errno));
+		In->map = NULL;
+		return (GMT_NOERROR);
+	}
+	In->map_size = buf.st_size;
+	base = In->map;
+	for (row = 0; row < n; row++) {	/* NaN records would be segment breaks, which we cannot skip in place */
+		if (gmt_M_is_dnan (base[row*n_cols+GMT_X]) || gmt_M_is_dnan (base[row*n_cols+GMT_Y])) {
+			GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: %s has NaN records; reading records instead\n", file);
+			munmap (In->map, In->map_size);
+			In->map = NULL;
+			return (GMT_NOERROR);
+		}
+	}
+
+	set_input_columns (n_input, In->n_z, src);
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) In->col[k] = base + src[k];
+	In->inc = n_cols;
+	In->n = n;
+	GMT_Report (API, GMT_MSG_VERBOSE, "Memory-mapped %" PRIu64 " records from %s\n", n, file);
+	return (GMT_NOERROR);
+#endif
+}
+
+#ifdef _OPENMP
+struct TRIANGULATE2_CHUNK {	/* The part of an ASCII file parsed by one thread */
+	char *start, *end;	/* First byte and one past the last byte of whole lines */
+	uint64_t first;		/* Row in the columns where the records of this chunk start */
+	uint64_t n;		/* Number of lines (an upper limit on the records), then records parsed */
+	bool failed;		/* true if some line needs the general GMT record reader */
+};
+
+GMT_LOCAL bool parse_ascii_lines (struct GMT_CTRL *GMT, struct TRIANGULATE2_CHUNK *C, unsigned int n_input, int src[], struct TRIANGULATE2_INPUT *In) {
+	/* Parse the records of one chunk straight into their rows of the columns.  We only take fields
+	 * that strtod reads in full, exactly as GMT does for plain numbers; anything else (dates, dd:mm,
+	 * Fortran exponents, NaN coordinates, short records, ...) returns false so the caller can hand
+	 * the whole file to the GMT record reader instead. */
+	unsigned int k, f;
+	int dst[TRIANGULATE2_N_COLS];
+	uint64_t row = C->first;
+	double val[TRIANGULATE2_N_COLS];
+	char *p = C->start, *eol = NULL, *next = NULL, *q = NULL, last[GMT_BUFSIZ];
+
+	for (f = 0; f < n_input; f++) dst[f] = -1;	/* Where each field goes, so a record costs n_input steps */
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) if (src[k] >= 0) dst[src[k]] = (int)k;
+
+	while (p < C->end) {
+		if ((eol = memchr (p, '\n', C->end - p)) != NULL)
+			next = eol + 1;
+		else {	/* Last line lacks a newline; parse a terminated copy so strtod cannot run off the end */
+			size_t len = C->end - p;
+			if (len >= GMT_BUFSIZ) return (false);
+			memcpy (last, p, len);	last[len] = '\0';
+			p = last;	eol = &last[len];	next = C->end;
+		}
+		if (strchr (GMT->current.setting.io_head_marker_in, p[0]) || p[0] == GMT->current.setting.io_seg_marker[GMT_IN]) {	/* Header or segment header */
+			p = next;
+			continue;
+		}
+		while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+		if (p == eol) {	/* Blank line */
+			p = next;
+			continue;
+		}
+		for (f = 0; f < n_input; f++) {
+			while (p < eol && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+			if (p == eol || *p == '\r') return (false);	/* Too few fields */
+			val[f] = strtod (p, &q);
+			if (q == p || !(q == eol || *q == ' ' || *q == '\t' || *q == ',' || *q == '\r')) return (false);	/* Not a plain number */
+			p = q;
+		}
+		if (gmt_M_is_dnan (val[GMT_X]) || gmt_M_is_dnan (val[GMT_Y])) return (false);	/* Let GMT decide what such records mean */
+		for (f = 0; f < n_input; f++) if (dst[f] >= 0) In->col[dst[f]][row] = val[f];
+		row++;
+		p = next;
+	}
+	C->n = row - C->first;
+	return (true);
+}
+#endif
+
+GMT_LOCAL bool parse_ascii (struct GMT_CTRL *GMT, struct GMT_OPTION *options, unsigned int n_input, struct TRIANGULATE2_INPUT *In) {
+	/* Parse a single regular ASCII file with all threads.  The file is split into chunks of whole
+	 * lines, the lines are counted to give each chunk its own rows in the columns, the chunks are
+	 * parsed concurrently and finally the gaps left by headers and blank lines are closed up.
+	 * Returns false if the input is not plain enough for us, so the caller must read records.
+	 * That includes any common input option that filters or rearranges records (-:, -d, -h, -i, -s). */
+#ifndef _OPENMP
+	gmt_M_unused (GMT);	gmt_M_unused (options);	gmt_M_unused (n_input);	gmt_M_unused (In);
+	return (false);	/* Only worthwhile with several threads */
+#else
+	int k, n_chunks, n_threads = TRIANGULATE2_THREADS (GMT), src[TRIANGULATE2_N_COLS];
+	unsigned int col, n_files = 0;
+	uint64_t n_lines = 0, n = 0;
+	size_t size;
+	char *file = NULL, *text = NULL, *p = NULL, *q = NULL;
+	bool failed = false;
+	struct stat buf;
+	struct TRIANGULATE2_CHUNK *C = NULL;
+	struct GMT_OPTION *opt = NULL;
+	struct GMTAPI_CTRL *API = GMT->parent;
+#ifndef WIN32
+	int fd;
+#else
+	FILE *fp = NULL;
+#endif
+
+	if (n_threads < 2) return (false);
+	for (opt = options; opt; opt = opt->next) if (opt->option == GMT_OPT_INFILE) file = opt->arg, n_files++;
+	if (n_files != 1 || GMT->common.b.active[GMT_IN] || GMT->common.i.active || GMT->current.setting.io_lonlat_toggle[GMT_IN] || GMT->current.setting.io_header[GMT_IN] || GMT->common.d.active[GMT_IN] || GMT->common.s.active)
+		return (false);
+	for (col = 0; col < n_input; col++)	/* Only plain numbers; leave dates, clocks and dd:mm:ss to GMT */
+		if (!(GMT->current.io.col_type[GMT_IN][col] == GMT_IS_FLOAT || GMT->current.io.col_type[GMT_IN][col] == GMT_IS_UNKNOWN)) return (false);
+	if (stat (file, &buf) || !S_ISREG (buf.st_mode) || buf.st_size == 0) return (false);
+	size = buf.st_size;
+
+#ifndef WIN32
+	if ((fd = open (file, O_RDONLY)) < 0) return (false);
+	text = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (text == MAP_FAILED) return (false);
+#else
+	if ((fp = fopen (file, "rb")) == NULL) return (false);
+	text = gmt_M_memory (GMT, NULL, size, char);
+	if (fread (text, 1, size, fp) != size) failed = true;
+	fclose (fp);
+	if (failed) {
+		gmt_M_free (GMT, text);
+		return (false);
+	}
+#endif
+
+	/* Split into chunks of whole lines, several per thread so an uneven chunk does not stall the rest */
+	n_chunks = 4 * n_threads;
+	if ((uint64_t)n_chunks > size / GMT_BUFSIZ + 1) n_chunks = (int)(size / GMT_BUFSIZ + 1);
+	C = gmt_M_memory (GMT, NULL, n_chunks, struct TRIANGULATE2_CHUNK);
+	for (k = 0, p = text; k < n_chunks; k++) {
+		C[k].start = p;
+		if (k < n_chunks - 1 && (q = text + (k + 1) * (size / n_chunks)) >= p && (q = memchr (q, '\n', text + size - q)) != NULL)
+			p = q + 1;
+		else if (k == n_chunks - 1 || q == NULL)
+			p = text + size;
+		C[k].end = p;
+	}
+
+	/* Count lines to find where in the columns each chunk will place its records */
+#pragma omp parallel for private(k,q) shared(n_chunks,C) num_threads(n_threads)
+	for (k = 0; k < n_chunks; k++) {
+		C[k].n = 0;
+		for (q = C[k].start; q < C[k].end && (q = memchr (q, '\n', C[k].end - q)) != NULL; q++) C[k].n++;
+		if (C[k].end > C[k].start && C[k].end[-1] != '\n') C[k].n++;	/* Unterminated last line */
+	}
+	for (k = 0; k < n_chunks; k++) {
+		C[k].first = n_lines;
+		n_lines += C[k].n;
+	}
+
+	set_input_columns (n_input, In->n_z, src);
+	alloc_columns (GMT, In, src, n_lines);
+
+#pragma omp parallel for private(k) shared(GMT,n_chunks,C,n_input,src,In) num_threads(n_threads) schedule(dynamic,1)
+	for (k = 0; k < n_chunks; k++)
+		C[k].failed = !parse_ascii_lines (GMT, &C[k], n_input, src, In);
+
+#ifndef WIN32
+	munmap (text, size);
+#else
+	gmt_M_free (GMT, text);
+#endif
+	for (k = 0; k < n_chunks; k++) if (C[k].failed) failed = true;
+	if (failed) {
+		GMT_Report (API, GMT_MSG_LONG_VERBOSE, "%s has records that need the GMT record reader\n", file);
+		gmt_M_free (GMT, C);
+		free_input (GMT, In);
+		return (false);
+	}
+
+	for (k = 0; k < n_chunks; k++) {	/* Close up the rows left unused by headers and blank lines */
+		if (C[k].first > n) for (col = 0; col < TRIANGULATE2_N_COLS; col++)
+			if (In->col[col]) memmove (&In->col[col][n], &In->col[col][C[k].first], C[k].n * sizeof (double));
+		n += C[k].n;
+	}
+	gmt_M_free (GMT, C);
+	In->n = n;
+	if (n && n < n_lines) resize_columns (GMT, In, n_lines, n);
+	GMT_Report (API, GMT_MSG_VERBOSE, "Parsed %" PRIu64 " records from %s using %d threads\n", n, file, n_threads);
+	return (true);
+#endif
+}
+
+GMT_LOCAL uint32_t hilbert_key (uint32_t x, uint32_t y) {
+	/* Distance along the Hilbert curve filling the 2^TRIANGULATE2_CURVE_BITS square to cell (x,y) */
+	uint32_t s, rx, ry, t, n = 1U << TRIANGULATE2_CURVE_BITS, d = 0;
+
+	for (s = n / 2; s > 0; s /= 2) {
+		rx = (x & s) > 0;
+		ry = (y & s) > 0;
+		d += s * s * ((3 * rx) ^ ry);
+		if (ry == 0) {	/* Rotate the quadrant */
+			if (rx == 1) {
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			t = x;	x = y;	y = t;
+		}
+	}
+	return (d);
+}
+
+GMT_LOCAL uint32_t morton_key (uint32_t x, uint32_t y) {
+	/* Interleave the bits of x and y, giving the position along the Morton (Z-order) curve */
+	unsigned int k;
+	uint32_t d = 0;
+
+	for (k = 0; k < TRIANGULATE2_CURVE_BITS; k++) d |= ((x >> k) & 1U) << (2 * k) | ((y >> k) & 1U) << (2 * k + 1);
+	return (d);
+}
+
+GMT_LOCAL uint64_t *curve_order (struct GMT_CTRL *GMT, double *x, double *y, uint64_t n, uint64_t inc, unsigned int curve) {
+	/* Return the permutation that visits the n points in the order of the chosen space-filling curve.
+	 * The keys are ranked with an LSD radix sort, one byte per pass, so this is O(n). */
+	unsigned int pass;
+	uint32_t *key = NULL, *key2 = NULL, *tk = NULL, cx, cy, max = (1U << TRIANGULATE2_CURVE_BITS) - 1;
+	uint64_t i, count[256], *order = NULL, *order2 = NULL, *to = NULL, sum, c;
+	double wesn[4], sx, sy;
+
+	wesn[XLO] = wesn[XHI] = x[0];	wesn[YLO] = wesn[YHI] = y[0];
+	for (i = 1; i < n; i++) {
+		if (x[i*inc] < wesn[XLO]) wesn[XLO] = x[i*inc]; else if (x[i*inc] > wesn[XHI]) wesn[XHI] = x[i*inc];
+		if (y[i*inc] < wesn[YLO]) wesn[YLO] = y[i*inc]; else if (y[i*inc] > wesn[YHI]) wesn[YHI] = y[i*inc];
+	}
+	sx = (wesn[XHI] > wesn[XLO]) ? max / (wesn[XHI] - wesn[XLO]) : 0.0;
+	sy = (wesn[YHI] > wesn[YLO]) ? max / (wesn[YHI] - wesn[YLO]) : 0.0;
+
+	key = gmt_M_memory (GMT, NULL, n, uint32_t);	key2 = gmt_M_memory (GMT, NULL, n, uint32_t);
+	order = gmt_M_memory (GMT, NULL, n, uint64_t);	order2 = gmt_M_memory (GMT, NULL, n, uint64_t);
+	for (i = 0; i < n; i++) {
+		cx = (uint32_t)lrint ((x[i*inc] - wesn[XLO]) * sx);
+		cy = (uint32_t)lrint ((y[i*inc] - wesn[YLO]) * sy);
+		key[i] = (curve == TRIANGULATE2_SORT_MORTON) ? morton_key (cx, cy) : hilbert_key (cx, cy);
+		order[i] = i;
+	}
+	for (pass = 0; pass < 4; pass++) {	/* Stable counting sort on each byte, least significant first */
+		gmt_M_memset (count, 256, uint64_t);
+		for (i = 0; i < n; i++) count[(key[i] >> (8 * pass)) & 255]++;
+		for (c = sum = 0; c < 256; c++) {
+			uint64_t m = count[c];
+			count[c] = sum;	sum += m;
+		}
+		for (i = 0; i < n; i++) {
+			c = count[(key[i] >> (8 * pass)) & 255]++;
+			key2[c] = key[i];	order2[c] = order[i];
+		}
+		tk = key;	key = key2;	key2 = tk;
+		to = order;	order = order2;	order2 = to;
+	}
+	gmt_M_free (GMT, key);	gmt_M_free (GMT, key2);	gmt_M_free (GMT, order2);
+	return (order);
+}
+
+GMT_LOCAL void sort_points (struct GMT_CTRL *GMT, struct TRIANGULATE2_INPUT *In, unsigned int curve) {
+	/* Reorder the points along a space-filling curve so that neighbors in space are also neighbors
+	 * in memory, which helps the triangulation and the gathers in the gridding loop.  The columns end
+	 * up contiguous in a new arena and In->id remembers where each point came from. */
+	int src[TRIANGULATE2_N_COLS];
+	unsigned int k;
+	int64_t i;
+	uint64_t *order = NULL;
+	struct TRIANGULATE2_INPUT Out;
+
+	order = curve_order (GMT, In->col[GMT_X], In->col[GMT_Y], In->n, In->inc, curve);
+	gmt_M_memset (&Out, 1, struct TRIANGULATE2_INPUT);
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) src[k] = (In->col[k]) ? (int)k : -1;
+	alloc_columns (GMT, &Out, src, In->n);
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) {
+		double *in = In->col[k], *out = Out.col[k];
+		uint64_t inc = In->inc;
+		if (!in) continue;
+#ifdef _OPENMP
+#pragma omp parallel for private(i) shared(In,in,out,order,inc) num_threads(TRIANGULATE2_THREADS (GMT))
+#endif
+		for (i = 0; i < (int64_t)In->n; i++) out[i] = in[order[i]*inc];
+	}
+	Out.n = In->n;	Out.inc = 1;
+	if (In->id) {	/* Already reordered once; compose so id still refers to input records */
+		for (i = 0; i < (int64_t)In->n; i++) order[i] = In->id[order[i]];
+	}
+	free_input (GMT, In);
+	*In = Out;
+	In->id = order;
+}
+
+GMT_LOCAL void restore_order (struct GMT_CTRL *GMT, struct TRIANGULATE2_INPUT *In, uint64_t *link, uint64_t np) {
+	/* Undo sort_points: put the points back in input order and renumber the triangle vertices
+	 * to match, so whatever we report from here on refers to the original input records */
+	unsigned int k;
+	uint64_t i;
+	double *scratch = NULL;
+
+	for (i = 0; i < 3 * np; i++) link[i] = In->id[link[i]];
+	scratch = gmt_M_memory (GMT, NULL, In->n, double);
+	for (k = 0; k < TRIANGULATE2_N_COLS; k++) {
+		if (!In->col[k]) continue;
+		for (i = 0; i < In->n; i++) scratch[In->id[i]] = In->col[k][i];
+		gmt_M_memcpy (In->col[k], scratch, In->n, double);
+	}
+	gmt_M_free (GMT, scratch);
+	gmt_M_free (GMT, In->id);
+}
+
+/* Built-in incremental Delaunay triangulation (-Ti).  Points are inserted in Hilbert curve order
+ * with the Bowyer-Watson algorithm: the new point is located by walking from the last triangle
+ * made, every triangle whose circumcircle contains it is removed, and the cavity is refilled with
+ * triangles fanning out from the point.  The hull is closed with ghost triangles that share the
+ * vertex TRIANGULATE2_GHOST, so points outside the hull need no special treatment.  Orientation
+ * and incircle tests use the error bounds of Shewchuk (1997, Discrete Comput. Geom., 18, 305-363)
+ * and fall back on exact expansion arithmetic when the floating point result cannot be trusted. */
+
+#define TRIANGULATE2_EPSILON	1.1102230246251565e-16	/* 2^-53, half a unit in the last place */
+#define TRIANGULATE2_CCW_BOUND	((3.0 + 16.0 * TRIANGULATE2_EPSILON) * TRIANGULATE2_EPSILON)
+#define TRIANGULATE2_ICC_BOUND	((10.0 + 96.0 * TRIANGULATE2_EPSILON) * TRIANGULATE2_EPSILON)
+#define TRIANGULATE2_GHOST	UINT64_MAX	/* The vertex at infinity */
+#define TRIANGULATE2_SMALL_CAVITY	16	/* Link cavity edges by linear search up to this size */
+#define TRIANGULATE2_N_SCALE		16	/* Longest expansion we scale: a squared distance */
+#define TRIANGULATE2_N_EXPANSION	512	/* Longest product: squared distance times a 2x2 determinant */
+
+#define is_ghost(T) ((T)->v[0] == TRIANGULATE2_GHOST || (T)->v[1] == TRIANGULATE2_GHOST || (T)->v[2] == TRIANGULATE2_GHOST)
+#define is_dead(T) ((T)->v[0] == TRIANGULATE2_GHOST && (T)->v[1] == TRIANGULATE2_GHOST)
+
+struct TRIANGULATE2_TRI {	/* One triangle of the built-in triangulation */
+	uint64_t v[3];	/* Vertices in counter-clockwise order */
+	uint64_t t[3];	/* Neighbor across the edge opposite v[k] */
+};
+
+struct TRIANGULATE2_HOLE {	/* An edge on the boundary of the cavity made by inserting a point */
+	uint64_t u, w;		/* Edge vertices, counter-clockwise as seen from inside the cavity */
+	uint64_t out;		/* Triangle on the other side */
+	uint64_t tri;		/* New triangle (u,w,p) */
+	unsigned int k;		/* Index of the edge in triangle out */
+};
+
+struct TRIANGULATE2_MESH {	/* State of the built-in triangulation */
+	double *x, *y;			/* The points */
+	struct TRIANGULATE2_TRI *T;	/* Triangles, including ghosts and dead ones awaiting reuse */
+	uint64_t *stamp;		/* Last visit of each triangle during a cavity search */
+	uint64_t n_tri, n_alloc;	/* Triangles in T and allocated */
+	uint64_t *stack, n_stack;	/* Cavity triangles to examine */
+	uint64_t *cavity, n_cavity;	/* Cavity triangles found */
+	struct TRIANGULATE2_HOLE *hole;	/* Cavity boundary */
+	uint64_t n_hole, n_work;	/* Edges in hole and allocated length of stack, cavity and hole */
+	uint64_t *dead, n_dead;		/* Free triangle slots */
+	uint64_t last;			/* Real triangle to start the next walk from */
+	uint64_t visit;			/* Insertion counter for stamp */
+	uint64_t n_dup;			/* Duplicate points skipped */
+	uint32_t seed;			/* For picking the first edge to test while walking */
+};
+
+GMT_LOCAL void two_sum (double a, double b, double *x, double *y) {
+	/* x + y = a + b exactly, with x the rounded sum */
+	double bv, av;
+	*x = a + b;
+	bv = *x - a;	av = *x - bv;
+	*y = (a - av) + (b - bv);
+}
+
+GMT_LOCAL void two_diff (double a, double b, double *x, double *y) {
+	/* x + y = a - b exactly, with x the rounded difference */
+	double bv, av;
+	*x = a - b;
+	bv = a - *x;	av = *x + bv;
+	*y = (a - av) + (bv - b);
+}
+
+GMT_LOCAL void two_prod (double a, double b, double *x, double *y) {
+	/* x + y = a * b exactly, with x the rounded product */
+	*x = a * b;
+	*y = fma (a, b, -*x);
+}
+
+GMT_LOCAL int diff_expansion (double a, double b, double *h) {
+	/* h = a - b as an expansion of one or two components */
+	two_diff (a, b, &h[1], &h[0]);
+	if (h[0] != 0.0) return (2);
+	h[0] = h[1];
+	return (1);
+}
+
+GMT_LOCAL int grow_expansion (int elen, double *e, double b, double *h) {
+	/* h = e + b, dropping zero components; h may be e */
+	int i, k = 0;
+	double q = b, s, r;
+
+	for (i = 0; i < elen; i++) {
+		two_sum (q, e[i], &s, &r);
+		q = s;
+		if (r != 0.0) h[k++] = r;
+	}
+	if (q != 0.0 || k == 0) h[k++] = q;
+	return (k);
+}
+
+GMT_LOCAL int scale_expansion (int elen, double *e, double b, double *h) {
+	/* h = e * b, dropping zero components */
+	int i, k = 0;
+	double q, s, r, p1, p0;
+
+	two_prod (e[0], b, &q, &r);
+	if (r != 0.0) h[k++] = r;
+	for (i = 1; i < elen; i++) {
+		two_prod (e[i], b, &p1, &p0);
+		two_sum (q, p0, &s, &r);
+		if (r != 0.0) h[k++] = r;
+		two_sum (p1, s, &q, &r);
+		if (r != 0.0) h[k++] = r;
+	}
+	if (q != 0.0 || k == 0) h[k++] = q;
+	return (k);
+}
+
+GMT_LOCAL int mul_expansion (int elen, double *e, int flen, double *f, double *h) {
+	/* h = e * f, which needs room for 2 * elen * flen components */
+	int i, j, hlen = 1, tlen;
+	double t[2*TRIANGULATE2_N_SCALE];
+
+	h[0] = 0.0;
+	for (j = 0; j < flen; j++) {
+		tlen = scale_expansion (elen, e, f[j], t);
+		for (i = 0; i < tlen; i++) hlen = grow_expansion (hlen, h, t[i], h);
+	}
+	return (hlen);
+}
+
+GMT_LOCAL int add_expansion (int elen, double *e, int flen, double *f, double *h) {
+	/* h = e + f; h may be e */
+	int i, hlen = elen;
+
+	if (h != e) gmt_M_memcpy (h, e, elen, double);
+	for (i = 0; i < flen; i++) hlen = grow_expansion (hlen, h, f[i], h);
+	return (hlen);
+}
+
+GMT_LOCAL int cross_expansion (int alen, double *a, int blen, double *b, int clen, double *c, int dlen, double *d, double *h) {
+	/* h = a * b - c * d */
+	int i, len1, len2;
+	double t1[8], t2[8];
+
+	len1 = mul_expansion (alen, a, blen, b, t1);
+	len2 = mul_expansion (clen, c, dlen, d, t2);
+	for (i = 0; i < len2; i++) t2[i] = -t2[i];
+	return (add_expansion (len1, t1, len2, t2, h));
+}
+
+GMT_LOCAL double orient2d_exact (double ax, double ay, double bx, double by, double cx, double cy) {
+	int acx_n, acy_n, bcx_n, bcy_n, len;
+	double acx[2], acy[2], bcx[2], bcy[2], det[16];
+
+	acx_n = diff_expansion (ax, cx, acx);	acy_n = diff_expansion (ay, cy, acy);
+	bcx_n = diff_expansion (bx, cx, bcx);	bcy_n = diff_expansion (by, cy, bcy);
+	len = cross_expansion (acx_n, acx, bcy_n, bcy, acy_n, acy, bcx_n, bcx, det);
+	return (det[len-1]);
+}
+
+GMT_LOCAL double orient2d (double ax, double ay, double bx, double by, double cx, double cy) {
+	/* Positive if a, b, c turn counter-clockwise, negative if clockwise, and zero if collinear */
+	double left = (ax - cx) * (by - cy), right = (ay - cy) * (bx - cx), det = left - right, sum;
+
+	if (left > 0.0) {
+		if (right <= 0.0) return (det);
+		sum = left + right;
+	}
+	else if (left < 0.0) {
+		if (right >= 0.0) return (det);
+		sum = -left - right;
+	}
+	else
+		return (det);
+	if (fabs (det) >= TRIANGULATE2_CCW_BOUND * sum) return (det);
+	return (orient2d_exact (ax, ay, bx, by, cx, cy));
+}
+
+GMT_LOCAL double incircle_exact (double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+	int k, n[6], blen, llen, tlen, len = 1;
+	double d[6][2], bc[16], lift[16], sq[8], t[TRIANGULATE2_N_EXPANSION], det[3*TRIANGULATE2_N_EXPANSION];
+	static int order[3][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}};	/* a, b, c and the two that follow */
+
+	n[0] = diff_expansion (ax, dx, d[0]);	n[3] = diff_expansion (ay, dy, d[3]);
+	n[1] = diff_expansion (bx, dx, d[1]);	n[4] = diff_expansion (by, dy, d[4]);
+	n[2] = diff_expansion (cx, dx, d[2]);	n[5] = diff_expansion (cy, dy, d[5]);
+	det[0] = 0.0;
+	for (k = 0; k < 3; k++) {	/* det = sum of |p - d|^2 * cross of the other two */
+		int p = order[k][0], q = order[k][1], r = order[k][2];
+		blen = cross_expansion (n[q], d[q], n[r+3], d[r+3], n[r], d[r], n[q+3], d[q+3], bc);
+		llen = mul_expansion (n[p], d[p], n[p], d[p], lift);
+		tlen = mul_expansion (n[p+3], d[p+3], n[p+3], d[p+3], sq);
+		llen = add_expansion (llen, lift, tlen, sq, lift);
+		tlen = mul_expansion (llen, lift, blen, bc, t);
+		len = add_expansion (len, det, tlen, t, det);
+	}
+	return (det[len-1]);
+}
+
+GMT_LOCAL double incircle (double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+	/* Positive if d lies inside the circle through the counter-clockwise a, b, c, negative if
+	 * outside, and zero if the four points are cocircular */
+	double adx = ax - dx, ady = ay - dy, bdx = bx - dx, bdy = by - dy, cdx = cx - dx, cdy = cy - dy;
+	double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy, cdxady = cdx * ady, adxcdy = adx * cdy, adxbdy = adx * bdy, bdxady = bdx * ady;
+	double alift = adx * adx + ady * ady, blift = bdx * bdx + bdy * bdy, clift = cdx * cdx + cdy * cdy;
+	double det, bound;
+
+	det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+	bound = TRIANGULATE2_ICC_BOUND * ((fabs (bdxcdy) + fabs (cdxbdy)) * alift + (fabs (cdxady) + fabs (adxcdy)) * blift + (fabs (adxbdy) + fabs (bdxady)) * clift);
+	if (det > bound || -det > bound) return (det);
+	return (incircle_exact (ax, ay, bx, by, cx, cy, dx, dy));
+}
+
+GMT_LOCAL bool in_conflict (struct TRIANGULATE2_MESH *M, uint64_t t, uint64_t p) {
+	/* True if point p lies inside the circumcircle of triangle t.  For a ghost triangle that
+	 * is the open half-plane beyond its hull edge together with the open edge itself. */
+	unsigned int k;
+	uint64_t *v = M->T[t].v, a, b;
+	double o, *x = M->x, *y = M->y;
+
+	for (k = 0; k < 3 && v[k] != TRIANGULATE2_GHOST; k++);
+	if (k == 3) return (incircle (x[v[0]], y[v[0]], x[v[1]], y[v[1]], x[v[2]], y[v[2]], x[p], y[p]) > 0.0);
+	a = v[(k+1)%3];	b = v[(k+2)%3];
+	if ((o = orient2d (x[a], y[a], x[b], y[b], x[p], y[p])) != 0.0) return (o > 0.0);
+	if (x[a] != x[b])	/* Collinear with the hull edge: in conflict if strictly between its ends */
+		return ((x[p] > x[a]) != (x[p] > x[b]) && x[p] != x[a] && x[p] != x[b]);
+	return ((y[p] > y[a]) != (y[p] > y[b]) && y[p] != y[a] && y[p] != y[b]);
+}
+
+GMT_LOCAL uint64_t locate_point (struct TRIANGULATE2_MESH *M, uint64_t p) {
+	/* Walk from the last triangle towards point p.  Returns the real triangle containing p,
+	 * or the ghost triangle whose hull edge separates p from the triangulation. */
+	unsigned int j, k, first;
+	uint64_t t = M->last, *v = NULL, steps = 0;
+	double *x = M->x, *y = M->y;
+
+	while (!is_ghost (&M->T[t])) {
+		v = M->T[t].v;
+		M->seed = M->seed * 1103515245U + 12345U;	/* Vary the first edge so the walk cannot cycle */
+		first = (M->seed >> 16) % 3;
+		for (j = 0; j < 3; j++) {
+			k = (first + j) % 3;
+			if (orient2d (x[v[(k+1)%3]], y[v[(k+1)%3]], x[v[(k+2)%3]], y[v[(k+2)%3]], x[p], y[p]) < 0.0) break;
+		}
+		if (j == 3) return (t);	/* p is on no edge's far side */
+		t = M->T[t].t[k];
+		if (++steps > M->n_tri) break;	/* Should never happen; search them all below */
+	}
+	if (steps <= M->n_tri) return (t);
+	for (t = 0; t < M->n_tri; t++) {
+		if (is_dead (&M->T[t]) || is_ghost (&M->T[t])) continue;
+		v = M->T[t].v;
+		for (k = 0; k < 3; k++)
+			if (orient2d (x[v[(k+1)%3]], y[v[(k+1)%3]], x[v[(k+2)%3]], y[v[(k+2)%3]], x[p], y[p]) < 0.0) break;
+		if (k == 3) return (t);
+	}
+	for (t = 0; t < M->n_tri; t++) if (!is_dead (&M->T[t]) && is_ghost (&M->T[t]) && in_conflict (M, t, p)) return (t);
+	return (M->last);
+}
+
+GMT_LOCAL void grow_work (struct TRIANGULATE2_MESH *M, struct GMT_CTRL *GMT, uint64_t need) {
+	/* Make room for need entries in the cavity search arrays */
+	if (need <= M->n_work) return;
+	M->n_work = MAX (2 * M->n_work, need);
+	M->stack  = gmt_M_memory (GMT, M->stack,  M->n_work, uint64_t);
+	M->cavity = gmt_M_memory (GMT, M->cavity, M->n_work, uint64_t);
+	M->dead   = gmt_M_memory (GMT, M->dead,   M->n_work, uint64_t);
+	M->hole   = gmt_M_memory (GMT, M->hole,   M->n_work, struct TRIANGULATE2_HOLE);
+}
+
+GMT_LOCAL uint64_t new_triangle (struct TRIANGULATE2_MESH *M, struct GMT_CTRL *GMT) {
+	/* Return a free triangle slot, recycling dead ones first */
+	if (M->n_dead) return (M->dead[--M->n_dead]);
+	if (M->n_tri == M->n_alloc) {
+		M->n_alloc = 2 * M->n_alloc;
+		M->T = gmt_M_memory (GMT, M->T, M->n_alloc, struct TRIANGULATE2_TRI);
+		M->stamp = gmt_M_memory (GMT, M->stamp, M->n_alloc, uint64_t);
+	}
+	return (M->n_tri++);
+}
+
+GMT_LOCAL int compare_hole (const void *p1, const void *p2) {
+	const struct TRIANGULATE2_HOLE *a = p1, *b = p2;
+
+	if (a->u < b->u) return (-1);
+	if (a->u > b->u) return (+1);
+	return (0);
+}
+
+GMT_LOCAL bool insert_point (struct TRIANGULATE2_MESH *M, struct GMT_CTRL *GMT, uint64_t p) {
+	/* Add point p to the triangulation; returns false if p duplicates an existing vertex */
+	unsigned int k, j;
+	uint64_t t, nb, i, m, *v = NULL, in_mark, out_mark;
+	struct TRIANGULATE2_HOLE *H = NULL, *B = NULL, key;
+	struct TRIANGULATE2_TRI *T = NULL;
+
+	t = locate_point (M, p);
+	v = M->T[t].v;
+	for (k = 0; k < 3; k++) if (v[k] != TRIANGULATE2_GHOST && M->x[v[k]] == M->x[p] && M->y[v[k]] == M->y[p]) return (false);
+
+	/* Search the cavity: all triangles connected to t whose circumcircle holds p */
+	M->visit++;
+	in_mark = 2 * M->visit;	out_mark = in_mark + 1;
+	M->n_stack = M->n_cavity = M->n_hole = 0;
+	M->stack[M->n_stack++] = t;
+	M->stamp[t] = in_mark;
+	while (M->n_stack) {
+		t = M->stack[--M->n_stack];
+		M->cavity[M->n_cavity++] = t;
+		for (k = 0; k < 3; k++) {
+			nb = M->T[t].t[k];
+			if (M->stamp[nb] == in_mark) continue;
+			grow_work (M, GMT, M->n_hole + M->n_cavity + M->n_stack + 2);
+			if (M->stamp[nb] == out_mark || !in_conflict (M, nb, p)) {	/* Shared edge is on the cavity boundary */
+				M->stamp[nb] = out_mark;
+				H = &M->hole[M->n_hole++];
+				H->u = M->T[t].v[(k+1)%3];	H->w = M->T[t].v[(k+2)%3];
+				H->out = nb;
+				for (j = 0; j < 3 && M->T[nb].t[j] != t; j++);
+				H->k = j;
+			}
+			else {
+				M->stamp[nb] = in_mark;
+				M->stack[M->n_stack++] = nb;
+			}
+		}
+	}
+
+	/* Fan the cavity boundary to p, reusing the cavity triangles */
+	for (i = 0; i < M->n_cavity; i++) M->dead[M->n_dead++] = M->cavity[i];
+	for (i = 0; i < M->n_hole; i++) {
+		H = &M->hole[i];
+		H->tri = new_triangle (M, GMT);
+		T = &M->T[H->tri];
+		T->v[0] = H->u;	T->v[1] = H->w;	T->v[2] = p;
+		T->t[2] = H->out;
+		M->T[H->out].t[H->k] = H->tri;
+		M->stamp[H->tri] = 0;
+		if (H->u != TRIANGULATE2_GHOST && H->w != TRIANGULATE2_GHOST) M->last = H->tri;
+	}
+	if (M->n_hole > TRIANGULATE2_SMALL_CAVITY) qsort (M->hole, M->n_hole, sizeof (struct TRIANGULATE2_HOLE), compare_hole);
+	for (i = 0; i < M->n_hole; i++) {	/* Neighbor across (w,p) is the new triangle whose edge starts at w */
+		H = &M->hole[i];
+		if (M->n_hole > TRIANGULATE2_SMALL_CAVITY) {
+			key.u = H->w;
+			B = bsearch (&key, M->hole, M->n_hole, sizeof (struct TRIANGULATE2_HOLE), compare_hole);
+		}
+		else {
+			for (m = 0; m < M->n_hole && M->hole[m].u != H->w; m++);
+			B = &M->hole[m];
+		}
+		M->T[H->tri].t[0] = B->tri;
+		M->T[B->tri].t[1] = H->tri;
+	}
+	for (i = 0; i < M->n_dead; i++) {	/* Mark unused slots so they are skipped on output */
+		T = &M->T[M->dead[i]];
+		T->v[0] = T->v[1] = T->v[2] = TRIANGULATE2_GHOST;
+	}
+	return (true);
+}
+
+GMT_LOCAL bool build_mesh (struct GMT_CTRL *GMT, struct TRIANGULATE2_MESH *M, double *x, double *y, uint64_t n) {
+	/* Triangulate the n points into M with the built-in engine.  Returns false, leaving nothing
+	 * to free, if there are not three points that are not collinear. */
+	uint64_t i, a, b = 0, c = 0, t, *order = NULL;
+	double o = 0.0;
+	struct TRIANGULATE2_TRI *T = NULL;
+
+	gmt_M_memset (M, 1, struct TRIANGULATE2_MESH);
+	if (n < 3) return (false);
+	order = curve_order (GMT, x, y, n, 1, TRIANGULATE2_SORT_HILBERT);
+
+	/* Start with the first three points along the curve that are not collinear */
+	a = order[0];
+	for (i = 1; i < n && x[order[i]] == x[a] && y[order[i]] == y[a]; i++);
+	if (i < n) b = order[i];
+	for (i++; i < n; i++) {
+		c = order[i];
+		if ((o = orient2d (x[a], y[a], x[b], y[b], x[c], y[c])) != 0.0) break;
+	}
+	if (i >= n) {
+		gmt_M_free (GMT, order);
+		return (false);
+	}
+	if (o < 0.0) {	/* Make it counter-clockwise */
+		t = b;	b = c;	c = t;
+	}
+
+	M->x = x;	M->y = y;
+	M->n_alloc = 2 * n + 16;
+	M->T = gmt_M_memory (GMT, NULL, M->n_alloc, struct TRIANGULATE2_TRI);
+	M->stamp = gmt_M_memory (GMT, NULL, M->n_alloc, uint64_t);
+	grow_work (M, GMT, 64);
+	M->n_tri = 4;	/* The first triangle and the three ghosts beyond its edges */
+	T = M->T;
+	T[0].v[0] = a;	T[0].v[1] = b;	T[0].v[2] = c;
+	T[0].t[0] = 2;	T[0].t[1] = 3;	T[0].t[2] = 1;
+	T[1].v[0] = b;	T[1].v[1] = a;	T[1].v[2] = TRIANGULATE2_GHOST;	/* Beyond a-b */
+	T[1].t[0] = 3;	T[1].t[1] = 2;	T[1].t[2] = 0;
+	T[2].v[0] = c;	T[2].v[1] = b;	T[2].v[2] = TRIANGULATE2_GHOST;	/* Beyond b-c */
+	T[2].t[0] = 1;	T[2].t[1] = 3;	T[2].t[2] = 0;
+	T[3].v[0] = a;	T[3].v[1] = c;	T[3].v[2] = TRIANGULATE2_GHOST;	/* Beyond c-a */
+	T[3].t[0] = 2;	T[3].t[1] = 1;	T[3].t[2] = 0;
+	M->last = 0;
+
+	for (i = 0; i < n; i++) {
+		if (order[i] == a || order[i] == b || order[i] == c) continue;
+		if (!insert_point (M, GMT, order[i])) M->n_dup++;
+	}
+	gmt_M_free (GMT, order);
+	return (true);
+}
+
+GMT_LOCAL void free_mesh (struct GMT_CTRL *GMT, struct TRIANGULATE2_MESH *M) {
+	gmt_M_free (GMT, M->T);		gmt_M_free (GMT, M->stamp);
+	gmt_M_free (GMT, M->stack);	gmt_M_free (GMT, M->cavity);
+	gmt_M_free (GMT, M->dead);	gmt_M_free (GMT, M->hole);
+}
+
+GMT_LOCAL uint64_t mesh_link (struct GMT_CTRL *GMT, struct TRIANGULATE2_MESH *M, uint64_t **link) {
+	/* Return the real triangles of M as vertex indices, three per triangle in counter-clockwise order */
+	uint64_t t, i = 0, np = 0;
+
+	for (t = 0; t < M->n_tri; t++) if (!is_dead (&M->T[t]) && !is_ghost (&M->T[t])) np++;
+	*link = gmt_M_memory (GMT, NULL, 3 * np, uint64_t);
+	for (t = 0; t < M->n_tri; t++) {
+		if (is_dead (&M->T[t]) || is_ghost (&M->T[t])) continue;
+		(*link)[i++] = M->T[t].v[0];	(*link)[i++] = M->T[t].v[1];	(*link)[i++] = M->T[t].v[2];
+	}
+	return (np);
+}
+
+GMT_LOCAL uint64_t incremental_delaunay (struct GMT_CTRL *GMT, double *x, double *y, uint64_t n, uint64_t **link) {
+	/* Triangulate the n points with the built-in engine.  Duplicate points are ignored. */
+	uint64_t np;
+	struct TRIANGULATE2_MESH M;
+
+	*link = NULL;
+	if (!build_mesh (GMT, &M, x, y, n)) {
+		GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Fewer than three points that are not collinear - no triangles\n");
+		return (0);
+	}
+	if (M.n_dup) GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Skipped %" PRIu64 " duplicate points\n", M.n_dup);
+	np = mesh_link (GMT, &M, link);
+	free_mesh (GMT, &M);
+	return (np);
+}
+
+/* Parallel triangulation (-Tp).  The points are split into vertical slabs holding equal numbers of
+ * points and each slab is triangulated by its own thread.  A slab triangle whose circumcircle stays
+ * strictly clear of the other slabs is in the triangulation of all the points and is kept, unless a
+ * triangle that is not kept lies across an edge from it with its far vertex on the circle.  The rest,
+ * near the slab boundaries and along the slab hulls, is redone in one go from their vertices.  That
+ * seam triangulation contains every edge between kept and other triangles, so we flood-fill it from
+ * those edges to find the parts the slabs already cover, and the rest fills the gaps. */
+
+#define TRIANGULATE2_SLAB_MIN	10000	/* Fewest points worth giving a slab of their own */
+#define TRIANGULATE2_SLAB_BINS	1024	/* Histogram bins per slab when placing the slab boundaries */
+
+struct TRIANGULATE2_SLAB {	/* One vertical strip of points for the parallel engine */
+	uint64_t n;		/* Points in the slab */
+	uint64_t *id;		/* Their indices into the input */
+	double *x, *y;		/* Their coordinates */
+	double xmin, xmax;	/* x-range of the points */
+	double lo, hi;		/* Nearest x of points in the slabs to the left and right */
+	uint64_t *link, np;	/* Triangles that are final, as input indices */
+	uint64_t *wall, n_wall;	/* Edges of final triangles not shared with other final ones, counter-clockwise pairs */
+};
+
+struct TRIANGULATE2_WALL {	/* Hash table entry for a wall edge */
+	uint64_t a, b;		/* Vertices with a < b, or a = TRIANGULATE2_GHOST if the slot is empty */
+	unsigned int dir;	/* 1 if some final triangle runs a -> b, 2 if b -> a */
+};
+
+GMT_LOCAL bool slab_clear (struct TRIANGULATE2_MESH *M, uint64_t t, double lo, double hi) {
+	/* True if the circumcircle of real triangle t clears x = lo and x = hi with room for the
+	 * rounding errors of the center and radius */
+	uint64_t *v = M->T[t].v;
+	double *x = M->x, *y = M->y, bx, by, cx, cy, B, C, d, ux, uy, r, err;
+
+	bx = x[v[1]] - x[v[0]];	by = y[v[1]] - y[v[0]];
+	cx = x[v[2]] - x[v[0]];	cy = y[v[2]] - y[v[0]];
+	if ((d = 2.0 * (bx * cy - by * cx)) == 0.0) return (false);
+	B = bx * bx + by * by;	C = cx * cx + cy * cy;
+	ux = (cy * B - by * C) / d;	uy = (bx * C - cx * B) / d;
+	r = hypot (ux, uy);
+	err = 16.0 * TRIANGULATE2_EPSILON * ((fabs (cy) * B + fabs (by) * C + fabs (bx) * C + fabs (cx) * B + 2.0 * (fabs (ux) + fabs (uy)) * (fabs (bx * cy) + fabs (by * cx))) / fabs (d) + r + fabs (x[v[0]]) + fabs (ux));
+	ux += x[v[0]];
+	return (ux - r - err > lo && ux + r + err < hi);
+}
+
+GMT_LOCAL bool slab_wall_ok (struct TRIANGULATE2_MESH *M, uint64_t t, char *final) {
+	/* True unless t borders a triangle that is not final across an edge whose far vertex is on or
+	 * inside the circumcircle of t, i.e. an edge the seam triangulation might not reproduce */
+	unsigned int k, j;
+	uint64_t *v = M->T[t].v, nb, q;
+	double *x = M->x, *y = M->y;
+
+	for (k = 0; k < 3; k++) {
+		nb = M->T[t].t[k];
+		if (final[nb] || is_ghost (&M->T[nb])) continue;
+		for (j = 0; j < 3 && M->T[nb].t[j] != t; j++);
+		q = M->T[nb].v[j];
+		if (incircle (x[v[0]], y[v[0]], x[v[1]], y[v[1]], x[v[2]], y[v[2]], x[q], y[q]) >= 0.0) return (false);
+	}
+	return (true);
+}
+
+GMT_LOCAL void triangulate_slab (struct GMT_CTRL *GMT, struct TRIANGULATE2_SLAB *S, bool *seam) {
+	/* Triangulate one slab, keep its final triangles and walls, and flag the vertices of the others
+	 * (and of the slab hull) as seam points */
+	unsigned int k;
+	uint64_t t, i, nb, n_stack = 0, *v = NULL, *stack = NULL;
+	char *final = NULL, *queued = NULL;	/* queued[t] is set while t is on the stack, so it holds each triangle at most once */
+	struct TRIANGULATE2_MESH M;
+
+	if (!build_mesh (GMT, &M, S->x, S->y, S->n)) {	/* Nothing to keep, so it is all seam */
+		for (i = 0; i < S->n; i++) seam[S->id[i]] = true;
+		return;
+	}
+	final = gmt_M_memory (GMT, NULL, M.n_tri, char);
+	queued = gmt_M_memory (GMT, NULL, M.n_tri, char);
+	stack = gmt_M_memory (GMT, NULL, M.n_tri, uint64_t);
+	for (t = 0; t < M.n_tri; t++) {
+		if (is_dead (&M.T[t]) || is_ghost (&M.T[t])) continue;
+		if ((final[t] = slab_clear (&M, t, S->lo, S->hi))) {stack[n_stack++] = t; queued[t] = 1;}
+	}
+	while (n_stack) {	/* Demote triangles until every wall separates two Delaunay cells */
+		t = stack[--n_stack];
+		queued[t] = 0;
+		if (!final[t] || slab_wall_ok (&M, t, final)) continue;
+		final[t] = 0;
+		for (k = 0; k < 3; k++) {	/* Their walls have moved, so check the final neighbors again */
+			nb = M.T[t].t[k];
+			if (final[nb] && !queued[nb]) {stack[n_stack++] = nb; queued[nb] = 1;}
+		}
+	}
+	gmt_M_free (GMT, stack);
+	gmt_M_free (GMT, queued);
+	for (t = 0; t < M.n_tri; t++) {	/* Count the final triangles and their walls */
+		if (!final[t]) continue;
+		S->np++;
+		for (k = 0; k < 3; k++) {
+			nb = M.T[t].t[k];
+			if (is_ghost (&M.T[nb]) || !final[nb]) S->n_wall++;
+		}
+	}
+	S->link = gmt_M_memory (GMT, NULL, 3 * S->np, uint64_t);
+	S->wall = gmt_M_memory (GMT, NULL, 2 * S->n_wall, uint64_t);
+	S->np = S->n_wall = 0;
+	for (t = 0; t < M.n_tri; t++) {
+		if (is_dead (&M.T[t])) continue;
+		v = M.T[t].v;
+		if (!final[t]) {	/* Ghost or not final: its vertices go to the seam */
+			for (k = 0; k < 3; k++) if (v[k] != TRIANGULATE2_GHOST) seam[S->id[v[k]]] = true;
+			continue;
+		}
+		for (k = 0; k < 3; k++) S->link[3*S->np+k] = S->id[v[k]];
+		S->np++;
+		for (k = 0; k < 3; k++) {
+			nb = M.T[t].t[k];
+			if (!is_ghost (&M.T[nb]) && final[nb]) continue;
+			S->wall[2*S->n_wall] = S->id[v[(k+1)%3]];	S->wall[2*S->n_wall+1] = S->id[v[(k+2)%3]];
+			S->n_wall++;
+		}
+	}
+	gmt_M_free (GMT, final);
+	free_mesh (GMT, &M);
+}
+
+GMT_LOCAL struct TRIANGULATE2_WALL *find_wall (struct TRIANGULATE2_WALL *W, uint64_t mask, uint64_t a, uint64_t b) {
+	/* Return the slot holding edge a-b, or the empty slot where it would go */
+	uint64_t h, t;
+
+	if (a > b) {
+		t = a;	a = b;	b = t;
+	}
+	h = (a * 0x9E3779B97F4A7C15ULL) ^ (b * 0xC2B2AE3D27D4EB4FULL);
+	for (h = (h ^ (h >> 29)) & mask; W[h].a != TRIANGULATE2_GHOST && (W[h].a != a || W[h].b != b); h = (h + 1) & mask);
+	return (&W[h]);
+}
+
+GMT_LOCAL uint64_t parallel_delaunay (struct GMT_CTRL *GMT, double *x, double *y, uint64_t n, unsigned int n_slabs, uint64_t **link) {
+	/* Triangulate the n points with the built-in engine using one slab per thread */
+	unsigned int s, k, *bin_slab = NULL;
+	int ks;
+	uint64_t i, t, nb, n_bins, b, sum, m = 0, np, n_wall = 0, mask, n_stack, *count = NULL, *sid = NULL, *stack = NULL, *v = NULL;
+	double wesn[2], scale, *sx = NULL, *sy = NULL;
+	bool *seam = NULL;
+	char *inside = NULL;
+	struct TRIANGULATE2_SLAB *S = NULL;
+	struct TRIANGULATE2_WALL *W = NULL, *w = NULL;
+	struct TRIANGULATE2_MESH M;
+
+	if (n_slabs > n / TRIANGULATE2_SLAB_MIN) n_slabs = (unsigned int)(n / TRIANGULATE2_SLAB_MIN);
+	wesn[0] = wesn[1] = x[0];
+	for (i = 1; i < n; i++) {
+		if (x[i] < wesn[0]) wesn[0] = x[i]; else if (x[i] > wesn[1]) wesn[1] = x[i];
+	}
+	if (n_slabs < 2 || wesn[1] == wesn[0]) return (incremental_delaunay (GMT, x, y, n, link));
+
+	/* Place the slab boundaries on a histogram of x so the slabs hold about n / n_slabs points each */
+	n_bins = (uint64_t)n_slabs * TRIANGULATE2_SLAB_BINS;
+	scale = n_bins / (wesn[1] - wesn[0]);
+	count = gmt_M_memory (GMT, NULL, n_bins, uint64_t);
+	bin_slab = gmt_M_memory (GMT, NULL, n_bins, unsigned int);
+	for (i = 0; i < n; i++) {
+		b = (uint64_t)((x[i] - wesn[0]) * scale);
+		count[MIN (b, n_bins - 1)]++;
+	}
+	for (b = sum = 0; b < n_bins; b++) {
+		bin_slab[b] = (unsigned int)MIN (sum * n_slabs / n, n_slabs - 1);
+		sum += count[b];
+	}
+	S = gmt_M_memory (GMT, NULL, n_slabs, struct TRIANGULATE2_SLAB);
+	for (b = 0; b < n_bins; b++) S[bin_slab[b]].n += count[b];
+	for (s = 0; s < n_slabs; s++) {
+		S[s].id = gmt_M_memory (GMT, NULL, S[s].n, uint64_t);
+		S[s].x = gmt_M_memory (GMT, NULL, S[s].n, double);
+		S[s].y = gmt_M_memory (GMT, NULL, S[s].n, double);
+		S[s].xmin = DBL_MAX;	S[s].xmax = -DBL_MAX;
+		S[s].n = 0;
+	}
+	for (i = 0; i < n; i++) {
+		b = (uint64_t)((x[i] - wesn[0]) * scale);
+		s = bin_slab[MIN (b, n_bins - 1)];
+		S[s].id[S[s].n] = i;	S[s].x[S[s].n] = x[i];	S[s].y[S[s].n] = y[i];
+		S[s].n++;
+		if (x[i] < S[s].xmin) S[s].xmin = x[i];
+		if (x[i] > S[s].xmax) S[s].xmax = x[i];
+	}
+	gmt_M_free (GMT, count);
+	gmt_M_free (GMT, bin_slab);
+	for (s = 0; s < n_slabs; s++) {	/* Closest points of the other slabs on either side */
+		S[s].lo = -DBL_MAX;	S[s].hi = DBL_MAX;
+		for (k = 0; k < s; k++) if (S[k].xmax > S[s].lo) S[s].lo = S[k].xmax;
+		for (k = s + 1; k < n_slabs; k++) if (S[k].xmin < S[s].hi) S[s].hi = S[k].xmin;
+	}
+
+	seam = gmt_M_memory (GMT, NULL, n, bool);
+#ifdef _OPENMP
+#pragma omp parallel for private(ks) shared(GMT,S,seam,n_slabs) num_threads(n_slabs) schedule(dynamic,1)
+#endif
+	for (ks = 0; ks < (int)n_slabs; ks++)
+		triangulate_slab (GMT, &S[ks], seam);
+
+	/* Triangulate the seam points */
+	for (i = 0; i < n; i++) if (seam[i]) m++;
+	sid = gmt_M_memory (GMT, NULL, m, uint64_t);
+	sx = gmt_M_memory (GMT, NULL, m, double);
+	sy = gmt_M_memory (GMT, NULL, m, double);
+	for (i = m = 0; i < n; i++) {
+		if (!seam[i]) continue;
+		sid[m] = i;	sx[m] = x[i];	sy[m] = y[i];
+		m++;
+	}
+	gmt_M_free (GMT, seam);
+	for (s = 0, np = 0; s < n_slabs; s++) {
+		np += S[s].np;
+		n_wall += S[s].n_wall;
+	}
+	GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "%u slabs gave %" PRIu64 " final triangles; triangulating %" PRIu64 " seam points\n", n_slabs, np, m);
+
+	if (build_mesh (GMT, &M, sx, sy, m)) {
+		/* Hash the walls, then flood-fill the seam triangles on the final side of them */
+		for (mask = 1; mask < 2 * n_wall; mask <<= 1);
+		W = gmt_M_memory (GMT, NULL, mask, struct TRIANGULATE2_WALL);
+		for (i = 0; i < mask; i++) W[i].a = TRIANGULATE2_GHOST;
+		mask--;
+		for (s = 0; s < n_slabs; s++) for (i = 0; i < S[s].n_wall; i++) {
+			uint64_t a = S[s].wall[2*i], c = S[s].wall[2*i+1];
+			w = find_wall (W, mask, a, c);
+			w->a = MIN (a, c);	w->b = MAX (a, c);
+			w->dir |= (a < c) ? 1 : 2;
+		}
+		inside = gmt_M_memory (GMT, NULL, M.n_tri, char);
+		stack = gmt_M_memory (GMT, NULL, M.n_tri, uint64_t);
+		n_stack = 0;
+		for (t = 0; t < M.n_tri; t++) {	/* Seeds: seam triangles running the same way as a wall */
+			if (is_dead (&M.T[t]) || is_ghost (&M.T[t])) continue;
+			v = M.T[t].v;
+			for (k = 0; k < 3; k++) {
+				uint64_t a = sid[v[(k+1)%3]], c = sid[v[(k+2)%3]];
+				w = find_wall (W, mask, a, c);
+				if (w->a != TRIANGULATE2_GHOST && (w->dir & ((a < c) ? 1 : 2))) break;
+			}
+			if (k < 3) {
+				inside[t] = 1;
+				stack[n_stack++] = t;
+			}
+		}
+		while (n_stack) {	/* Spread without crossing walls */
+			t = stack[--n_stack];
+			v = M.T[t].v;
+			for (k = 0; k < 3; k++) {
+				nb = M.T[t].t[k];
+				if (inside[nb] || is_ghost (&M.T[nb])) continue;
+				if (find_wall (W, mask, sid[v[(k+1)%3]], sid[v[(k+2)%3]])->a != TRIANGULATE2_GHOST) continue;
+				inside[nb] = 1;
+				stack[n_stack++] = nb;
+			}
+		}
+		gmt_M_free (GMT, stack);
+		gmt_M_free (GMT, W);
+		for (t = 0; t < M.n_tri; t++) if (!inside[t] && !is_dead (&M.T[t]) && !is_ghost (&M.T[t])) np++;
+	}
+
+	*link = gmt_M_memory (GMT, NULL, 3 * np, uint64_t);
+	for (s = 0, i = 0; s < n_slabs; s++) {
+		gmt_M_memcpy (&(*link)[3*i], S[s].link, 3 * S[s].np, uint64_t);
+		i += S[s].np;
+		gmt_M_free (GMT, S[s].link);	gmt_M_free (GMT, S[s].wall);
+		gmt_M_free (GMT, S[s].id);	gmt_M_free (GMT, S[s].x);	gmt_M_free (GMT, S[s].y);
+	}
+	for (t = 0; t < M.n_tri; t++) {
+		if (inside[t] || is_dead (&M.T[t]) || is_ghost (&M.T[t])) continue;
+		for (k = 0; k < 3; k++) (*link)[3*i+k] = sid[M.T[t].v[k]];
+		i++;
+	}
+	if (M.n_tri) {
+		gmt_M_free (GMT, inside);
+		free_mesh (GMT, &M);
+	}
+	gmt_M_free (GMT, S);
+	gmt_M_free (GMT, sid);	gmt_M_free (GMT, sx);	gmt_M_free (GMT, sy);
+	return (np);
+}
+
+#define next_corner(e) (((e) % 3 == 2) ? (e) - 2 : (e) + 1)	/* Next corner of the same triangle in link */
+
+struct TRIANGULATE2_HALF {	/* One side of an edge, filed under its lower vertex */
+	uint64_t upper;		/* The other vertex */
+	uint64_t edge;		/* Position of its first vertex in link */
+};
+
+GMT_LOCAL int compare_half (const void *p1, const void *p2) {
+	const struct TRIANGULATE2_HALF *a = p1, *b = p2;
+
+	if (a->upper < b->upper) return (-1);
+	if (a->upper > b->upper) return (+1);
+	return (0);
+}
+
+#define TRIANGULATE2_SHORT_BUCKET	32	/* Handle edge buckets up to this size without sorting them */
+
+GMT_LOCAL uint64_t *neighbor_table (struct GMT_CTRL *GMT, uint64_t *link, uint64_t np, uint64_t n) {
+	/* Find the triangle on the other side of each edge in linear time.  neighbor[3*t+k] is the
+	 * triangle sharing the edge from vertex k to k+1 of triangle t, or UINT64_MAX on the hull.  The
+	 * edges are counting sorted on their lower vertex so that both sides of an edge end up in the
+	 * same short bucket, and the buckets are then paired up in parallel. */
+	int64_t v;
+	uint64_t e, i, j, k, *start = NULL, *neighbor = NULL;
+	struct TRIANGULATE2_HALF *half = NULL;
+
+	neighbor = gmt_M_memory (GMT, NULL, MAX (3 * np, 1), uint64_t);
+	start = gmt_M_memory (GMT, NULL, n + 1, uint64_t);
+	half = gmt_M_memory (GMT, NULL, MAX (3 * np, 1), struct TRIANGULATE2_HALF);
+	for (e = 0; e < 3 * np; e++) start[MIN (link[e], link[next_corner (e)]) + 1]++;
+	for (i = 0; i < n; i++) start[i+1] += start[i];
+	for (e = 0; e < 3 * np; e++) {
+		j = start[MIN (link[e], link[next_corner (e)])]++;
+		half[j].edge = e;	half[j].upper = MAX (link[e], link[next_corner (e)]);
+		neighbor[e] = UINT64_MAX;
+	}
+	for (i = n; i > 0; i--) start[i] = start[i-1];	/* Undo the advance */
+	start[0] = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for private(v,j,k) shared(start,half,neighbor,n) schedule(dynamic,4096) num_threads(TRIANGULATE2_THREADS (GMT))
+#endif
+	for (v = 0; v < (int64_t)n; v++) {
+		struct TRIANGULATE2_HALF *b = &half[start[v]];
+		uint64_t m = start[v+1] - start[v];
+		if (m > TRIANGULATE2_SHORT_BUCKET) {	/* Only around a vertex of very high degree */
+			qsort (b, m, sizeof (struct TRIANGULATE2_HALF), compare_half);
+			for (j = 1; j < m; j++) {
+				if (b[j].upper != b[j-1].upper || neighbor[b[j-1].edge] != UINT64_MAX) continue;
+				neighbor[b[j-1].edge] = b[j].edge / 3;	neighbor[b[j].edge] = b[j-1].edge / 3;
+			}
+		}
+		else {
+			for (j = 0; j < m; j++) {
+				if (neighbor[b[j].edge] != UINT64_MAX) continue;	/* Already paired */
+				for (k = j + 1; k < m && b[k].upper != b[j].upper; k++);
+				if (k == m) continue;	/* On the hull */
+				neighbor[b[j].edge] = b[k].edge / 3;	neighbor[b[k].edge] = b[j].edge / 3;
+			}
+		}
+	}
+	gmt_M_free (GMT, half);
+	gmt_M_free (GMT, start);
+	return (neighbor);
+}
+
+struct TRIANGULATE2_SPOT {	/* A point filed by its coordinates, to find duplicates */
+	double x, y;
+	uint64_t id;
+};
+
+GMT_LOCAL int compare_spot (const void *p1, const void *p2) {
+	const struct TRIANGULATE2_SPOT *a = p1, *b = p2;
+
+	if (a->x < b->x) return (-1);
+	if (a->x > b->x) return (+1);
+	if (a->y < b->y) return (-1);
+	if (a->y > b->y) return (+1);
+	return (0);
+}
+
+GMT_LOCAL bool check_delaunay (struct GMT_CTRL *GMT, double *x, double *y, uint64_t n, uint64_t *link, uint64_t np, char *engine) {
+	/* Debugging aid (-Vd) for our own triangulators.  Checks that no triangle is flat and all turn the
+	 * same way, that the two triangles on either side of an edge agree, that every point left out
+	 * duplicates one that is in, that Euler's formula np = 2 * n_used - n_hull - 2 holds, and that no
+	 * vertex is inside the circumcircle of the triangle across an edge from it.  The last makes the
+	 * triangulation locally and hence globally Delaunay.  Returns true if all is well. */
+	uint64_t t, e, u, d, k, n_used = 0, n_hull = 0, n_flat = 0, n_turn = 0, n_odd = 0, n_circle = 0, n_lost = 0, *neighbor = NULL;
+	double o, sign = 0.0;
+	bool *used = NULL, in, ok;
+	struct TRIANGULATE2_SPOT *spot = NULL;
+
+	neighbor = neighbor_table (GMT, link, np, n);
+	used = gmt_M_memory (GMT, NULL, n, bool);
+	for (t = 0; t < np; t++) {
+		o = orient2d (x[link[3*t]], y[link[3*t]], x[link[3*t+1]], y[link[3*t+1]], x[link[3*t+2]], y[link[3*t+2]]);
+		if (o == 0.0) n_flat++;
+		else if (sign == 0.0) sign = (o > 0.0) ? 1.0 : -1.0;
+		else if (o * sign < 0.0) n_turn++;
+		for (k = 0; k < 3; k++) used[link[3*t+k]] = true;
+	}
+	for (e = 0; e < 3 * np; e++) {
+		if ((u = neighbor[e]) == UINT64_MAX) {	/* Hull edge */
+			n_hull++;
+			continue;
+		}
+		for (k = 0; k < 3 && neighbor[3*u+k] != e / 3; k++);
+		if (k == 3) {	/* u does not know about us */
+			n_odd++;
+			continue;
+		}
+		for (k = 0; k < 3 && (link[3*u+k] == link[e] || link[3*u+k] == link[next_corner (e)]); k++);
+		d = link[3*u+k];	/* Vertex of u across the edge */
+		t = 3 * (e / 3);
+		if (sign * incircle (x[link[t]], y[link[t]], x[link[t+1]], y[link[t+1]], x[link[t+2]], y[link[t+2]], x[d], y[d]) > 0.0) n_circle++;
+	}
+	for (k = 0; k < n; k++) if (used[k]) n_used++;
+	if (np && n_used < n) {	/* The points left out must all be duplicates */
+		spot = gmt_M_memory (GMT, NULL, n, struct TRIANGULATE2_SPOT);
+		for (k = 0; k < n; k++) spot[k].x = x[k], spot[k].y = y[k], spot[k].id = k;
+		qsort (spot, n, sizeof (struct TRIANGULATE2_SPOT), compare_spot);
+		for (k = 0; k < n; k = d) {	/* Each group of equal points must have one in */
+			for (d = k, in = false; d < n && spot[d].x == spot[k].x && spot[d].y == spot[k].y; d++) if (used[spot[d].id]) in = true;
+			if (!in) n_lost += d - k;
+		}
+		gmt_M_free (GMT, spot);
+	}
+	ok = (n_flat + n_turn + n_odd + n_circle + n_lost == 0 && (np == 0 || np + n_hull + 2 == 2 * n_used));
+	if (ok)
+		GMT_Report (GMT->parent, GMT_MSG_DEBUG, "%s triangulation checked: %" PRIu64 " triangles, %" PRIu64 " of %" PRIu64 " points used, %" PRIu64 " on the hull\n", engine, np, n_used, n, n_hull);
+	else
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Warning: %s triangulation fails its check: %" PRIu64 " triangles for %" PRIu64 " vertices and %" PRIu64 " hull edges, %" PRIu64 " flat, %" PRIu64 " turned, %" PRIu64 " mismatched neighbors, %" PRIu64 " circle violations, %" PRIu64 " points lost\n",
+			engine, np, n_used, n_hull, n_flat, n_turn, n_odd, n_circle, n_lost);
+	gmt_M_free (GMT, used);
+	gmt_M_free (GMT, neighbor);
+	return (ok);
+}
+
+GMT_LOCAL uint64_t delaunay (struct GMT_CTRL *GMT, double *x, double *y, uint64_t n, unsigned int engine, uint64_t **link) {
+	/* Triangulate with the selected engine and return the triangles as 64-bit vertex indices.
+	 * The library triangulators index with int, so the caller must ensure n <= INT_MAX for them.
+	 * With -Vd the result of the built-in engines is checked (see check_delaunay). */
+	int *ilink = NULL;
+	uint64_t np, k;
+
+	if (engine == TRIANGULATE2_ENGINE_BUILTIN) {
+		np = incremental_delaunay (GMT, x, y, n, link);
+		if (gmt_M_is_verbose (GMT, GMT_MSG_DEBUG)) (void)check_delaunay (GMT, x, y, n, *link, np, "Built-in");
+		return (np);
+	}
+	if (engine == TRIANGULATE2_ENGINE_PARALLEL) {
+#ifdef _OPENMP
+		np = parallel_delaunay (GMT, x, y, n, TRIANGULATE2_THREADS (GMT), link);
+#else
+		np = incremental_delaunay (GMT, x, y, n, link);
+#endif
+		if (gmt_M_is_verbose (GMT, GMT_MSG_DEBUG)) (void)check_delaunay (GMT, x, y, n, *link, np, "Parallel");
+		return (np);
+	}
+	np = gmt_delaunay (GMT, x, y, n, &ilink);
+	*link = gmt_M_memory (GMT, NULL, 3 * np, uint64_t);
+	for (k = 0; k < 3 * np; k++) (*link)[k] = (uint64_t)ilink[k];
+	gmt_delaunay_free (GMT, &ilink);
+	return (np);
+}
+
+GMT_LOCAL int write_tin (struct GMT_CTRL *GMT, char *file, double *x, double *y, uint64_t inc, uint64_t n, uint64_t *link, uint64_t *neighbor, uint64_t np) {
+	/* Save the points and their triangulation, and the neighbor table if not NULL, as a TIN file (-L+w) */
+	bool failed;
+	uint64_t i, k;
+	double *col = NULL;
+	struct TRIANGULATE2_TIN_HEADER H;
+	FILE *fp = NULL;
+
+	gmt_M_memset (&H, 1, struct TRIANGULATE2_TIN_HEADER);
+	strncpy (H.magic, TRIANGULATE2_TIN_MAGIC, 8U);
+	H.n_points = n;	H.n_triangles = np;
+	if (neighbor) H.flags |= TRIANGULATE2_TIN_NEIGHBORS;
+	H.wesn[XLO] = H.wesn[XHI] = x[0];	H.wesn[YLO] = H.wesn[YHI] = y[0];
+	for (i = 1; i < n; i++) {
+		if (x[i*inc] < H.wesn[XLO]) H.wesn[XLO] = x[i*inc]; else if (x[i*inc] > H.wesn[XHI]) H.wesn[XHI] = x[i*inc];
+		if (y[i*inc] < H.wesn[YLO]) H.wesn[YLO] = y[i*inc]; else if (y[i*inc] > H.wesn[YHI]) H.wesn[YHI] = y[i*inc];
+	}
+	if ((fp = fopen (file, "wb")) == NULL) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Cannot create file %s\n", file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	failed = (fwrite (&H, sizeof (struct TRIANGULATE2_TIN_HEADER), 1U, fp) != 1U);
+	col = gmt_M_memory (GMT, NULL, n, double);
+	for (k = 0; k < 2 && !failed; k++) {	/* The x then y column, unstrided */
+		double *in = (k == 0) ? x : y;
+		for (i = 0; i < n; i++) col[i] = in[i*inc];
+		failed = (fwrite (col, sizeof (double), n, fp) != n);
+	}
+	gmt_M_free (GMT, col);
+	if (!failed) failed = (fwrite (link, sizeof (uint64_t), 3 * np, fp) != 3 * np || (neighbor && fwrite (neighbor, sizeof (uint64_t), 3 * np, fp) != 3 * np));
+	if (fclose (fp)) failed = true;	/* The last of it may only be written now */
+	if (failed) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Error writing TIN file %s\n", file);
+		return (GMT_RUNTIME_ERROR);
+	}
+	GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Wrote %" PRIu64 " points and %" PRIu64 " triangles to TIN file %s\n", n, np, file);
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int map_file (struct GMT_CTRL *GMT, char *file, char option, size_t min_size, void **map, size_t *size) {
+	/* Load a whole binary file of at least min_size bytes for option -<option>, memory-mapped
+	 * (copy on write) where possible, otherwise read into memory */
+	struct stat buf;
+	struct GMTAPI_CTRL *API = GMT->parent;
+#ifndef WIN32
+	int fd;
+#else
+	FILE *fp = NULL;
+#endif
+
+	*map = NULL;	*size = 0;
+	if (stat (file, &buf) || (size_t)buf.st_size < min_size) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -%c option: %s is missing or too short\n", option, file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+#ifndef WIN32
+	if ((fd = open (file, O_RDONLY)) < 0) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Cannot open file %s\n", file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	*map = mmap (NULL, buf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (*map == MAP_FAILED) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -%c option: Unable to memory-map %s (%s)\n", option, file, strerror (errno));
+		*map = NULL;
+		return (GMT_RUNTIME_ERROR);
+	}
+	*size = buf.st_size;
+#else
+	if ((fp = fopen (file, "rb")) == NULL) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Cannot open file %s\n", file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	*map = gmt_M_memory (GMT, NULL, buf.st_size, char);
+	if (fread (*map, 1U, buf.st_size, fp) == (size_t)buf.st_size) *size = buf.st_size;
+	fclose (fp);
+#endif
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int read_tin (struct GMT_CTRL *GMT, char *file, double *x, double *y, uint64_t inc, uint64_t n, struct TRIANGULATE2_TIN *Tin) {
+	/* Load a TIN file (-L), memory-mapped where possible, and make sure its vertices are our input
+	 * points and its vertex and neighbor indices are in range, since we index with them unchecked */
+	int error;
+	uint64_t i, n_bad = 0, *base = NULL;
+	size_t size, triangle_size;
+	struct GMTAPI_CTRL *API = GMT->parent;
+
+	gmt_M_memset (Tin, 1, struct TRIANGULATE2_TIN);
+	if ((error = map_file (GMT, file, 'L', sizeof (struct TRIANGULATE2_TIN_HEADER), &Tin->map, &Tin->size)) != GMT_NOERROR) return (error);
+	Tin->H = Tin->map;
+	triangle_size = ((Tin->H->flags & TRIANGULATE2_TIN_NEIGHBORS) ? 6 : 3) * sizeof (uint64_t);
+	size = Tin->size - sizeof (struct TRIANGULATE2_TIN_HEADER);	/* Work down from the size so a bad header cannot overflow */
+	if (Tin->size < sizeof (struct TRIANGULATE2_TIN_HEADER) || strncmp (Tin->H->magic, TRIANGULATE2_TIN_MAGIC, 8U) ||
+		Tin->H->n_points > size / (2 * sizeof (double)) || (size -= 2 * Tin->H->n_points * sizeof (double)) % triangle_size ||
+		size / triangle_size != Tin->H->n_triangles) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -L option: %s is not a TIN file written on this kind of computer\n", file);
+		free_tin (GMT, Tin);
+		return (GMT_RUNTIME_ERROR);
+	}
+	Tin->x = (double *)(Tin->H + 1);
+	Tin->y = Tin->x + Tin->H->n_points;
+	base = (uint64_t *)(Tin->y + Tin->H->n_points);
+	Tin->link = base;
+	if (Tin->H->flags & TRIANGULATE2_TIN_NEIGHBORS) Tin->neighbor = base + 3 * Tin->H->n_triangles;
+
+	if (Tin->H->n_points != n) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -L option: %s holds %" PRIu64 " points but we read %" PRIu64 "\n", file, Tin->H->n_points, n);
+		free_tin (GMT, Tin);
+		return (GMT_RUNTIME_ERROR);
+	}
+	for (i = 0; i < n; i++) {
+		if (Tin->x[i] != x[i*inc] || Tin->y[i] != y[i*inc]) {
+			GMT_Report (API, GMT_MSG_NORMAL, "Error -L option: Input point %" PRIu64 " differs from the vertex saved in %s\n", i, file);
+			free_tin (GMT, Tin);
+			return (GMT_RUNTIME_ERROR);
+		}
+	}
+	for (i = 0; i < 3 * Tin->H->n_triangles; i++) {
+		if (Tin->link[i] >= n) n_bad++;
+		if (Tin->neighbor && Tin->neighbor[i] >= Tin->H->n_triangles && Tin->neighbor[i] != UINT64_MAX) n_bad++;
+	}
+	if (n_bad) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -L option: %s has %" PRIu64 " vertex or neighbor indices out of range\n", file, n_bad);
+		free_tin (GMT, Tin);
+		return (GMT_RUNTIME_ERROR);
+	}
+	GMT_Report (API, GMT_MSG_VERBOSE, "Loaded %" PRIu64 " triangles from TIN file %s\n", Tin->H->n_triangles, file);
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int write_weights (struct GMT_CTRL *GMT, char *file, double *x, double *y, uint64_t inc, uint64_t n, uint64_t *link, uint64_t np, struct GMT_GRID_HEADER *h, struct TRIANGULATE2_WEIGHT *weight) {
+	/* Save the points, their triangulation and the barycentric weights of every grid node that fell
+	 * in a triangle (weight[node].tri is UINT64_MAX for the others) as a weight file (-W+w) */
+	bool failed;
+	uint64_t i, k, node, n_nodes = (uint64_t)h->n_columns * h->n_rows;
+	double *col = NULL;
+	struct TRIANGULATE2_WEIGHT_HEADER H;
+	FILE *fp = NULL;
+
+	gmt_M_memset (&H, 1, struct TRIANGULATE2_WEIGHT_HEADER);
+	strncpy (H.magic, TRIANGULATE2_WEIGHT_MAGIC, 8U);
+	H.n_points = n;	H.n_triangles = np;
+	H.n_columns = h->n_columns;	H.n_rows = h->n_rows;	H.registration = h->registration;
+	gmt_M_memcpy (H.wesn, h->wesn, 4, double);	gmt_M_memcpy (H.inc, h->inc, 2, double);
+	for (node = 0; node < n_nodes; node++) {	/* Squeeze out the nodes outside the triangulation */
+		if (weight[node].tri == UINT64_MAX) continue;
+		weight[H.n_nodes] = weight[node];
+		weight[H.n_nodes++].node = node;
+	}
+	if ((fp = fopen (file, "wb")) == NULL) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Cannot create file %s\n", file);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	failed = (fwrite (&H, sizeof (struct TRIANGULATE2_WEIGHT_HEADER), 1U, fp) != 1U);
+	col = gmt_M_memory (GMT, NULL, n, double);
+	for (k = 0; k < 2 && !failed; k++) {	/* The x then y column, unstrided */
+		double *in = (k == 0) ? x : y;
+		for (i = 0; i < n; i++) col[i] = in[i*inc];
+		failed = (fwrite (col, sizeof (double), n, fp) != n);
+	}
+	gmt_M_free (GMT, col);
+	if (!failed) failed = (fwrite (link, sizeof (uint64_t), 3 * np, fp) != 3 * np || fwrite (weight, sizeof (struct TRIANGULATE2_WEIGHT), H.n_nodes, fp) != H.n_nodes);
+	if (fclose (fp)) failed = true;	/* The last of it may only be written now */
+	if (failed) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Error writing weight file %s\n", file);
+		return (GMT_RUNTIME_ERROR);
+	}
+	GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Wrote weights of %" PRIu64 " grid nodes to %s\n", H.n_nodes, file);
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL int read_weights (struct GMT_CTRL *GMT, char *file, double *x, double *y, uint64_t inc, uint64_t n, struct GMT_GRID_HEADER *h, struct TRIANGULATE2_WEIGHTS *W) {
+	/* Load a weight file (-W) and make sure it was made from our input points and for our grid, and
+	 * that its vertex, triangle and node indices are in range, since we index with them unchecked */
+	int error;
+	uint64_t i, n_bad = 0, n_nodes;
+	size_t size;
+	struct GMTAPI_CTRL *API = GMT->parent;
+
+	gmt_M_memset (W, 1, struct TRIANGULATE2_WEIGHTS);
+	if ((error = map_file (GMT, file, 'W', sizeof (struct TRIANGULATE2_WEIGHT_HEADER), &W->map, &W->size)) != GMT_NOERROR) return (error);
+	W->H = W->map;
+	size = W->size - sizeof (struct TRIANGULATE2_WEIGHT_HEADER);	/* Work down from the size so a bad header cannot overflow */
+	if (W->size < sizeof (struct TRIANGULATE2_WEIGHT_HEADER) || strncmp (W->H->magic, TRIANGULATE2_WEIGHT_MAGIC, 8U) ||
+		W->H->n_points > size / (2 * sizeof (double)) || (size -= 2 * W->H->n_points * sizeof (double)) / (3 * sizeof (uint64_t)) < W->H->n_triangles ||
+		(size -= 3 * W->H->n_triangles * sizeof (uint64_t)) % sizeof (struct TRIANGULATE2_WEIGHT) || size / sizeof (struct TRIANGULATE2_WEIGHT) != W->H->n_nodes) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -W option: %s is not a weight file written on this kind of computer\n", file);
+		free_weights (GMT, W);
+		return (GMT_RUNTIME_ERROR);
+	}
+	W->x = (double *)(W->H + 1);
+	W->y = W->x + W->H->n_points;
+	W->link = (uint64_t *)(W->y + W->H->n_points);
+	W->weight = (struct TRIANGULATE2_WEIGHT *)(W->link + 3 * W->H->n_triangles);
+
+	if (W->H->n_columns != h->n_columns || W->H->n_rows != h->n_rows || W->H->registration != h->registration ||
+		fabs (W->H->wesn[XLO] - h->wesn[XLO]) > GMT_CONV8_LIMIT * h->inc[GMT_X] || fabs (W->H->wesn[YHI] - h->wesn[YHI]) > GMT_CONV8_LIMIT * h->inc[GMT_Y] ||
+		fabs (W->H->inc[GMT_X] - h->inc[GMT_X]) > GMT_CONV8_LIMIT * h->inc[GMT_X] || fabs (W->H->inc[GMT_Y] - h->inc[GMT_Y]) > GMT_CONV8_LIMIT * h->inc[GMT_Y]) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -W option: %s was made for another -R -I grid\n", file);
+		free_weights (GMT, W);
+		return (GMT_RUNTIME_ERROR);
+	}
+	if (W->H->n_points != n) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -W option: %s holds %" PRIu64 " points but we read %" PRIu64 "\n", file, W->H->n_points, n);
+		free_weights (GMT, W);
+		return (GMT_RUNTIME_ERROR);
+	}
+	for (i = 0; i < n; i++) {
+		if (W->x[i] != x[i*inc] || W->y[i] != y[i*inc]) {
+			GMT_Report (API, GMT_MSG_NORMAL, "Error -W option: Input point %" PRIu64 " differs from the one saved in %s\n", i, file);
+			free_weights (GMT, W);
+			return (GMT_RUNTIME_ERROR);
+		}
+	}
+	for (i = 0; i < 3 * W->H->n_triangles; i++) if (W->link[i] >= n) n_bad++;
+	n_nodes = (uint64_t)h->n_columns * h->n_rows;
+	for (i = 0; i < W->H->n_nodes; i++) if (W->weight[i].node >= n_nodes || W->weight[i].tri >= W->H->n_triangles) n_bad++;
+	if (n_bad) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error -W option: %s has %" PRIu64 " vertex, triangle or node indices out of range\n", file, n_bad);
+		free_weights (GMT, W);
+		return (GMT_RUNTIME_ERROR);
+	}
+	GMT_Report (API, GMT_MSG_VERBOSE, "Loaded weights of %" PRIu64 " grid nodes from %s\n", W->H->n_nodes, file);
+	return (GMT_NOERROR);
+}
+
+GMT_LOCAL void free_link (struct GMT_CTRL *GMT, struct TRIANGULATE2_TIN *Tin, struct TRIANGULATE2_WEIGHTS *W, uint64_t **link, uint64_t **neighbor) {
+	/* Release the triangles and their neighbor table, whether we made them or they live in a TIN or
+	 * weight file */
+	if (*neighbor != Tin->neighbor) gmt_M_free (GMT, *neighbor);
+	*neighbor = NULL;
+	if (Tin->map)
+		free_tin (GMT, Tin);
+	else if (W->map)
+		free_weights (GMT, W);
+	else
+		gmt_M_free (GMT, *link);
+	*link = NULL;
+}
+
+/* The uncertainty kernels evaluate the CURVE uncertainty at the n nodes x[0..n-1] of a row span at y
+ * inside a triangle, with t2 the squared slope tangents of those nodes, and write them to out.  Each
+ * vertex uncertainty grows with the distance d to the vertex, as 1 + ((d + s_H * h) / delta_min)^alpha,
+ * and with the slope, and the three are combined by inverse distance weighting.  A node within one
+ * unit of a vertex takes that vertex' value.  The macros below build one kernel per exponent so that
+ * the common integer alphas avoid pow altogether; Q_ALPHA is the expression for q^alpha. */
+
+typedef void (*sigma_span_func) (double *x, int n, double y, double *vx, double *vy, double *h, double *v, double *t2, double alpha, double delta_min, double s_H, float *out);
+
+#define TRIANGULATE2_SIGMA_SPAN(func,Q_ALPHA) \
+GMT_LOCAL void func (double *x, int n, double y, double *vx, double *vy, double *h, double *v, double *t2, double alpha, double delta_min, double s_H, float *out) { \
+	int i; \
+	unsigned int k; \
+	double d[3], u[3], dx, dy, q, uw, w, r_delta = 1.0 / delta_min; \
+	gmt_M_unused (alpha); \
+	for (i = 0; i < n; i++) { \
+		for (k = 0; k < 3; k++) {	/* Same operations as the vector kernels, fused where they are */ \
+			dx = x[i] - vx[k];	dy = y - vy[k]; \
+			d[k] = sqrt (fma (dx, dx, dy * dy)); \
+			q = (d[k] + s_H * h[k]) * r_delta; \
+			u[k] = fma (v[k] * v[k], (Q_ALPHA) + 1.0, t2[i] * (h[k] * h[k])); \
+		} \
+		for (k = 0; k < 3 && d[k] >= 1.0; k++);	/* As the integer abs() of the original code */ \
+		if (k < 3) {	/* Within one unit of a vertex */ \
+			out[i] = (float)sqrt (u[k]); \
+			continue; \
+		} \
+		for (k = 0, uw = w = 0.0; k < 3; k++) { \
+			uw += u[k] / d[k]; \
+			w += 1.0 / d[k]; \
+		} \
+		out[i] = (float)sqrt (uw / w); \
+	} \
+}
+
+TRIANGULATE2_SIGMA_SPAN (sigma_span_pow, pow (q, alpha))
+TRIANGULATE2_SIGMA_SPAN (sigma_span_alpha1, q)
+TRIANGULATE2_SIGMA_SPAN (sigma_span_alpha2, q * q)
+TRIANGULATE2_SIGMA_SPAN (sigma_span_alpha3, q * q * q)
+
+#ifdef TRIANGULATE2_X86_SIMD
+/* Vector versions for the integer alphas, four (AVX2) or eight (AVX-512) nodes at a time.  They are
+ * compiled for those instruction sets regardless of the build flags and only called if the CPU has
+ * them.  The nodes left over at the end of the span go to the scalar kernel for the same alpha.
+ * Each lane does exactly the operations of the scalar kernel, which uses fma() where these use
+ * fused multiply-adds, so the grids do not depend on the CPU (unless the compiler is allowed to
+ * fuse other expressions, e.g. -ffp-contract=fast with -march=native). */
+
+#define TRIANGULATE2_SIGMA_SPAN_AVX2(func,scalar,Q_ALPHA) \
+__attribute__((target("avx2,fma"))) \
+GMT_LOCAL void func (double *x, int n, double y, double *vx, double *vy, double *h, double *v, double *t2, double alpha, double delta_min, double s_H, float *out) { \
+	int i, k; \
+	__m256d X, T2, dx, dy, d, q, u, num, den, snap, hit, on; \
+	const __m256d one = _mm256_set1_pd (1.0), eps = _mm256_set1_pd (1.0), r_delta = _mm256_set1_pd (1.0 / delta_min); \
+	for (i = 0; i + 4 <= n; i += 4) { \
+		X = _mm256_loadu_pd (&x[i]);	T2 = _mm256_loadu_pd (&t2[i]); \
+		num = den = snap = on = _mm256_setzero_pd (); \
+		for (k = 0; k < 3; k++) { \
+			dx = _mm256_sub_pd (X, _mm256_set1_pd (vx[k])); \
+			dy = _mm256_set1_pd (y - vy[k]); \
+			d = _mm256_sqrt_pd (_mm256_fmadd_pd (dx, dx, _mm256_mul_pd (dy, dy))); \
+			q = _mm256_mul_pd (_mm256_add_pd (d, _mm256_set1_pd (s_H * h[k])), r_delta); \
+			u = _mm256_fmadd_pd (_mm256_set1_pd (v[k] * v[k]), _mm256_add_pd (Q_ALPHA, one), _mm256_mul_pd (T2, _mm256_set1_pd (h[k] * h[k]))); \
+			num = _mm256_add_pd (num, _mm256_div_pd (u, d)); \
+			den = _mm256_add_pd (den, _mm256_div_pd (one, d)); \
+			hit = _mm256_andnot_pd (on, _mm256_cmp_pd (d, eps, _CMP_LT_OQ));	/* First vertex the node sits on */ \
+			snap = _mm256_blendv_pd (snap, u, hit); \
+			on = _mm256_or_pd (on, hit); \
+		} \
+		_mm_storeu_ps (&out[i], _mm256_cvtpd_ps (_mm256_sqrt_pd (_mm256_blendv_pd (_mm256_div_pd (num, den), snap, on)))); \
+	} \
+	if (i < n) scalar (&x[i], n - i, y, vx, vy, h, v, &t2[i], alpha, delta_min, s_H, &out[i]); \
+}
+
+#define TRIANGULATE2_SIGMA_SPAN_AVX512(func,scalar,Q_ALPHA) \
+__attribute__((target("avx512f"))) \
+GMT_LOCAL void func (double *x, int n, double y, double *vx, double *vy, double *h, double *v, double *t2, double alpha, double delta_min, double s_H, float *out) { \
+	int i, k; \
+	__mmask8 hit, on; \
+	__m512d X, T2, dx, dy, d, q, u, num, den, snap; \
+	const __m512d one = _mm512_set1_pd (1.0), eps = _mm512_set1_pd (1.0), r_delta = _mm512_set1_pd (1.0 / delta_min); \
+	for (i = 0; i + 8 <= n; i += 8) { \
+		X = _mm512_loadu_pd (&x[i]);	T2 = _mm512_loadu_pd (&t2[i]); \
+		num = den = snap = _mm512_setzero_pd (); \
+		on = 0; \
+		for (k = 0; k < 3; k++) { \
+			dx = _mm512_sub_pd (X, _mm512_set1_pd (vx[k])); \
+			dy = _mm512_set1_pd (y - vy[k]); \
+			d = _mm512_sqrt_pd (_mm512_fmadd_pd (dx, dx, _mm512_mul_pd (dy, dy))); \
+			q = _mm512_mul_pd (_mm512_add_pd (d, _mm512_set1_pd (s_H * h[k])), r_delta); \
+			u = _mm512_fmadd_pd (_mm512_set1_pd (v[k] * v[k]), _mm512_add_pd (Q_ALPHA, one), _mm512_mul_pd (T2, _mm512_set1_pd (h[k] * h[k]))); \
+			num = _mm512_add_pd (num, _mm512_div_pd (u, d)); \
+			den = _mm512_add_pd (den, _mm512_div_pd (one, d)); \
+			hit = _mm512_cmp_pd_mask (d, eps, _CMP_LT_OQ) & ~on;	/* First vertex the node sits on */ \
+			snap = _mm512_mask_blend_pd (hit, snap, u); \
+			on |= hit; \
+		} \
+		_mm256_storeu_ps (&out[i], _mm512_cvtpd_ps (_mm512_sqrt_pd (_mm512_mask_blend_pd (on, _mm512_div_pd (num, den), snap)))); \
+	} \
+	if (i < n) scalar (&x[i], n - i, y, vx, vy, h, v, &t2[i], alpha, delta_min, s_H, &out[i]); \
+}
+
+TRIANGULATE2_SIGMA_SPAN_AVX2 (sigma_span_avx2_alpha1, sigma_span_alpha1, q)
+TRIANGULATE2_SIGMA_SPAN_AVX2 (sigma_span_avx2_alpha2, sigma_span_alpha2, _mm256_mul_pd (q, q))
+TRIANGULATE2_SIGMA_SPAN_AVX2 (sigma_span_avx2_alpha3, sigma_span_alpha3, _mm256_mul_pd (_mm256_mul_pd (q, q), q))
+TRIANGULATE2_SIGMA_SPAN_AVX512 (sigma_span_avx512_alpha1, sigma_span_alpha1, q)
+TRIANGULATE2_SIGMA_SPAN_AVX512 (sigma_span_avx512_alpha2, sigma_span_alpha2, _mm512_mul_pd (q, q))
+TRIANGULATE2_SIGMA_SPAN_AVX512 (sigma_span_avx512_alpha3, sigma_span_alpha3, _mm512_mul_pd (_mm512_mul_pd (q, q), q))
+#endif
+
+GMT_LOCAL sigma_span_func select_sigma_span (struct GMT_CTRL *GMT, double alpha) {
+	/* Pick the fastest uncertainty kernel this CPU can run for this alpha.  Integer alphas 1-3 get
+	 * their own kernels, anything else goes through pow */
+	unsigned int power = (alpha == 1.0 || alpha == 2.0 || alpha == 3.0) ? (unsigned int)alpha : 0;
+	static sigma_span_func scalar[4] = {sigma_span_pow, sigma_span_alpha1, sigma_span_alpha2, sigma_span_alpha3};
+#ifdef TRIANGULATE2_X86_SIMD
+	static sigma_span_func avx2[4] = {NULL, sigma_span_avx2_alpha1, sigma_span_avx2_alpha2, sigma_span_avx2_alpha3};
+	static sigma_span_func avx512[4] = {NULL, sigma_span_avx512_alpha1, sigma_span_avx512_alpha2, sigma_span_avx512_alpha3};
+
+	if (power) {
+		__builtin_cpu_init ();
+		if (__builtin_cpu_supports ("avx512f")) {
+			GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "Using the AVX-512 uncertainty kernel for alpha = %u\n", power);
+			return (avx512[power]);
+		}
+		if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma")) {
+			GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "Using the AVX2 uncertainty kernel for alpha = %u\n", power);
+			return (avx2[power]);
+		}
+	}
+#endif
+	if (power)
+		GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "Using the scalar uncertainty kernel for alpha = %u\n", power);
+	else
+		GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "Using the general uncertainty kernel for alpha = %g\n", alpha);
+	return (scalar[power]);
+}
+
+GMT_LOCAL unsigned int closed_edges (double *vx, double *vy, double orient, unsigned int hull) {
+	/* A node on an edge shared by two triangles must belong to just one of them.  Walking around the
+	 * triangle counter-clockwise, an edge going down, or going right along a row, keeps its nodes
+	 * (with y up, these are its left and bottom edges); the same edge seen from the other triangle runs
+	 * the other way and does not.  This is the same as nudging each node a tiny bit right and up, so
+	 * nodes on shared vertices are also counted once.  Edges on the hull (bits in hull) have no other
+	 * side and always keep their nodes.  Returns bit k set if the edge from vertex k to k+1 is closed. */
+	unsigned int k, closed = hull;
+	double dx, dy;
+
+	for (k = 0; k < 3; k++) {
+		dx = vx[k+1] - vx[k];	dy = vy[k+1] - vy[k];
+		if (orient < 0.0) dx = -dx, dy = -dy;	/* Clockwise triangle */
+		if (dy < 0.0 || (dy == 0.0 && dx > 0.0)) closed |= (1U << k);
+	}
+	return (closed);
+}
+
+GMT_LOCAL bool node_in_triangle (double *vx, double *vy, double orient, unsigned int closed, double x, double y) {
+	/* True if (x,y) is inside the triangle whose vertices turn the way given by the sign of orient,
+	 * or on one of its closed edges (see closed_edges) */
+	unsigned int k;
+	double s;
+
+	for (k = 0; k < 3; k++) {
+		s = orient2d (vx[k], vy[k], vx[k+1], vy[k+1], x, y);
+		if (orient < 0.0) s = -s;
+		if (s < 0.0 || (s == 0.0 && !(closed & (1U << k)))) return (false);
+	}
+	return (true);
+}
+
+#define TRIANGULATE2_MIN_RUN		1024	/* Fewest query points worth another thread (-C) */
+
+GMT_LOCAL unsigned char *hull_edges (struct GMT_CTRL *GMT, uint64_t *neighbor, uint64_t np) {
+	/* Flag the edges that belong to only one triangle, i.e., those on the hull.  Bit k of flag[t] is
+	 * set if the edge from vertex k to k+1 of triangle t is one. */
+	uint64_t t;
+	unsigned int k;
+	unsigned char *flag = gmt_M_memory (GMT, NULL, np, unsigned char);
+
+	for (t = 0; t < np; t++) for (k = 0; k < 3; k++) if (neighbor[3*t+k] == UINT64_MAX) flag[t] |= (1U << k);
+	return (flag);
+}
+
+GMT_LOCAL uint64_t *unique_edges (struct GMT_CTRL *GMT, uint64_t *link, uint64_t *neighbor, uint64_t np, uint64_t n, uint64_t **start) {
+	/* Find the unique edges of the np triangles without sorting them all.  Each edge is taken once,
+	 * from the triangle with the lower number (see neighbor_table), and counting sorted on its lower
+	 * vertex; the short buckets are then sorted on the upper vertex in parallel.  Vertex i is the lower
+	 * end of the edges to end[(*start)[i]] up to end[(*start)[i+1]-1], in increasing order; (*start)[n]
+	 * edges in all. */
+	int64_t i;
+	uint64_t e, j, k, v, *first = NULL, *end = NULL;
+
+	first = gmt_M_memory (GMT, NULL, n + 1, uint64_t);
+	for (e = 0; e < 3 * np; e++) if (neighbor[e] > e / 3) first[MIN (link[e], link[next_corner (e)]) + 1]++;
+	for (v = 0; v < n; v++) first[v+1] += first[v];
+	end = gmt_M_memory (GMT, NULL, MAX (first[n], 1), uint64_t);
+	for (e = 0; e < 3 * np; e++) if (neighbor[e] > e / 3) end[first[MIN (link[e], link[next_corner (e)])]++] = MAX (link[e], link[next_corner (e)]);
+	for (v = n; v > 0; v--) first[v] = first[v-1];	/* Undo the advance */
+	first[0] = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i,j,k,v) shared(first,end,n) schedule(dynamic,4096) num_threads(TRIANGULATE2_THREADS (GMT))
+#endif
+	for (i = 0; i < (int64_t)n; i++) {	/* Sort each bucket */
+		uint64_t *b = &end[first[i]], m = first[i+1] - first[i];
+		if (m > TRIANGULATE2_SHORT_BUCKET)	/* Only around a vertex of very high degree */
+			qsort (b, m, sizeof (uint64_t), compare_vertex);
+		else {
+			for (j = 1; j < m; j++) {
+				v = b[j];
+				for (k = j; k > 0 && b[k-1] > v; k--) b[k] = b[k-1];
+				b[k] = v;
+			}
+		}
+	}
+	*start = first;
+	return (end);
+}
+
+GMT_LOCAL bool row_span (struct GMT_CTRL *GMT, struct GMT_GRID_HEADER *h, double *vx, double *vy, double orient, unsigned int closed, int row, int *col_min, int *col_max) {
+	/* Find the first and last column of the nodes on this row that are inside the triangle or on its closed edges.
+	 * The span follows from where the row crosses the edges; its ends are then checked with exact
+	 * predicates and moved a node in or out as needed.  Returns false if the row misses. */
+	unsigned int k;
+	int c0, c1, last = (int)h->n_columns - 1;
+	double y = gmt_M_grd_row_to_y (GMT, row, h), xl = DBL_MAX, xr = -DBL_MAX, xs;
+
+	for (k = 0; k < 3; k++) {	/* Where the row meets each edge */
+		if ((y < vy[k] && y < vy[k+1]) || (y > vy[k] && y > vy[k+1])) continue;
+		if (vy[k] == vy[k+1]) {	/* Along the row */
+			xl = MIN (xl, MIN (vx[k], vx[k+1]));	xr = MAX (xr, MAX (vx[k], vx[k+1]));
+		}
+		else {
+			xs = vx[k] + (y - vy[k]) * (vx[k+1] - vx[k]) / (vy[k+1] - vy[k]);
+			xl = MIN (xl, xs);	xr = MAX (xr, xs);
+		}
+	}
+	if (xl > xr) return (false);
+	xl = ceil ((xl - h->wesn[XLO]) * h->r_inc[GMT_X] - h->xy_off);
+	xr = floor ((xr - h->wesn[XLO]) * h->r_inc[GMT_X] - h->xy_off);
+	if (xr < 0.0 || xl > last) return (false);
+	c0 = (xl < 0.0) ? 0 : (int)xl;
+	c1 = (xr > last) ? last : (int)xr;
+	while (c0 > 0 && node_in_triangle (vx, vy, orient, closed, gmt_M_grd_col_to_x (GMT, c0-1, h), y)) c0--;
+	while (c0 <= c1 && !node_in_triangle (vx, vy, orient, closed, gmt_M_grd_col_to_x (GMT, c0, h), y)) c0++;
+	while (c1 < last && node_in_triangle (vx, vy, orient, closed, gmt_M_grd_col_to_x (GMT, c1+1, h), y)) c1++;
+	while (c1 >= c0 && !node_in_triangle (vx, vy, orient, closed, gmt_M_grd_col_to_x (GMT, c1, h), y)) c1--;
+	*col_min = c0;	*col_max = c1;
+	return (c0 <= c1);
+}
+
+struct TRIANGULATE2_RASTER {	/* What gridding a triangle needs */
+	uint64_t *link, inc;	/* Triangle vertices, and stride of the point arrays */
+	unsigned char *hull;	/* Hull edges of each triangle (see hull_edges) */
+	double *x, *y;		/* Points */
+	double *z[TRIANGULATE2_MAX_Z];	/* Their values, one array per z column */
+	unsigned int n_z;	/* Number of z columns */
+	double *h, *v;		/* CURVE: Horizontal and vertical point uncertainties, or NULL */
+	double *xcol;		/* x of each grid column */
+	struct TRIANGULATE2_WEIGHT *weight;	/* If not NULL, where each grid node fell (-W+w) */
+	double alpha, delta_min, s_H;	/* CURVE model parameters */
+	sigma_span_func sigma_span;	/* CURVE kernel */
+	int row0;		/* Grid row held in the first row of the Product arrays (tiled output) */
+	int slope_row0;		/* CURVE: Grid row held in the first row of tan2_slope */
+	double *tan2_slope;	/* CURVE: Squared tangent of the slope at each grid node of the rows read so far */
+	char *slope_file;	/* CURVE: Slope grid to read as needed, or NULL */
+	struct GMT_GRID_HEADER *header;
+	struct GMT_GRID **Product;	/* TRIANGULATE2_GRID (kind, b, n_z) is the grid of that kind for z column b, or NULL */
+	uint64_t *neighbor, np;	/* Triangles across each edge (see neighbor_table), for walking to query points (-C) */
+	uint64_t *jump;		/* A triangle in each cell of a coarse grid over the points to start walks from, or NULL */
+	unsigned int jump_nx, jump_ny;	/* Its dimensions */
+	double jump_x0, jump_y0, jump_r_inc[2], jump_d2;	/* Its lower left corner, 1 / cell sizes and squared cell diagonal */
+	struct GMT_GRID *Slopes;	/* CURVE: The whole slope grid, for query points (-C) */
+};
+
+GMT_LOCAL bool triangle_rows (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, uint64_t k, int *row_min, int *row_max) {
+	/* Find the grid rows triangle k may cover, clipped to the grid.  Returns false if it is outside */
+	int c0, c1, r0, r1, n_columns = (int)R->header->n_columns, n_rows = (int)R->header->n_rows;
+	uint64_t ij1 = R->inc * R->link[3*k], ij2 = R->inc * R->link[3*k+1], ij3 = R->inc * R->link[3*k+2];
+	double *x = R->x, *y = R->y;
+
+	c0 = (int)gmt_M_grd_x_to_col (GMT, MIN (MIN (x[ij1], x[ij2]), x[ij3]), R->header);
+	c1 = (int)gmt_M_grd_x_to_col (GMT, MAX (MAX (x[ij1], x[ij2]), x[ij3]), R->header);
+	r0 = (int)gmt_M_grd_y_to_row (GMT, MAX (MAX (y[ij1], y[ij2]), y[ij3]), R->header);
+	r1 = (int)gmt_M_grd_y_to_row (GMT, MIN (MIN (y[ij1], y[ij2]), y[ij3]), R->header);
+	if (c1 < 0 || c0 >= n_columns || r1 < 0 || r0 >= n_rows) return (false);	/* Left, right, above or below */
+	*row_min = MAX (r0, 0);	*row_max = MIN (r1, n_rows - 1);
+	return (true);
+}
+
+GMT_LOCAL void triangle_vertices (struct TRIANGULATE2_RASTER *R, uint64_t k, uint64_t *ij, double *vx, double *vy, double *uh, double *uv) {
+	/* Get the corners of triangle k, closing the x,y polygon in vx[3], vy[3], and where their values are */
+	unsigned int j;
+
+	for (j = 0; j < 3; j++) {
+		ij[j] = R->inc * R->link[3*k+j];
+		vx[j] = R->x[ij[j]];	vy[j] = R->y[ij[j]];
+		if (R->h) {	//CURVE: Uncertainties are unsigned
+			uh[j] = fabs (R->h[ij[j]]);	uv[j] = fabs (R->v[ij[j]]);
+		}
+	}
+	vx[3] = vx[0];	vy[3] = vy[0];
+}
+
+GMT_LOCAL void triangle_planes (struct TRIANGULATE2_RASTER *R, uint64_t *ij, double *vx, double *vy, double *a, double *b, double *c) {
+	/* Find equation for the plane through the corners as z = ax + by + c, for each z column */
+	unsigned int k;
+	double f, xkj, ykj, zkj, xlj, ylj, zlj, *z = NULL;
+
+	xkj = vx[1] - vx[0];	ykj = vy[1] - vy[0];
+	xlj = vx[2] - vx[0];	ylj = vy[2] - vy[0];
+	f = 1.0 / (xkj * ylj - ykj * xlj);
+
+	for (k = 0; k < R->n_z; k++) {
+		z = R->z[k];
+		zkj = z[ij[1]] - z[ij[0]];	zlj = z[ij[2]] - z[ij[0]];
+		a[k] = -f * (ykj * zlj - zkj * ylj);
+		b[k] = -f * (zkj * xlj - xkj * zlj);
+		c[k] = -a[k] * vx[1] - b[k] * vy[1] + z[ij[1]];
+	}
+}
+
+GMT_LOCAL void grid_triangle (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, uint64_t k, int row_lo, int row_hi) {
+	/* Set the nodes of triangle k on rows row_lo-row_hi in all the grids asked for */
+	int row, col, col_min, col_max, row_min, row_max, n;
+	unsigned int closed, j, n_z = R->n_z;
+	uint64_t p, ps, ij[3];
+	double vx[4], vy[4], uh[3], uv[3], a[TRIANGULATE2_MAX_Z], b[TRIANGULATE2_MAX_Z], c[TRIANGULATE2_MAX_Z], orient, yp, *x = NULL;
+	float *out = NULL;
+	struct GMT_GRID **Product = R->Product, *Z = NULL, *DX = NULL, *DY = NULL;
+	bool planes = (Product[TRIANGULATE2_GRID (TRIANGULATE2_Z, 0, n_z)] || Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDX, 0, n_z)] || Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDY, 0, n_z)]);
+
+	if (!triangle_rows (GMT, R, k, &row_min, &row_max)) return;
+	row_min = MAX (row_min, row_lo);	row_max = MIN (row_max, row_hi);
+	if (row_min > row_max) return;
+
+	triangle_vertices (R, k, ij, vx, vy, uh, uv);
+	if ((orient = orient2d (vx[0], vy[0], vx[1], vy[1], vx[2], vy[2])) == 0.0) return;	/* No area */
+	closed = closed_edges (vx, vy, orient, R->hull[k]);
+	if (planes) triangle_planes (R, ij, vx, vy, a, b, c);
+
+	for (row = row_min; row <= row_max; row++) {	/* Visit only the nodes inside, row by row */
+		if (!row_span (GMT, R->header, vx, vy, orient, closed, row, &col_min, &col_max)) continue;
+		yp = gmt_M_grd_row_to_y (GMT, row, R->header);
+		p = gmt_M_ijp (R->header, row - R->row0, col_min);
+		n = col_max - col_min + 1;	x = &R->xcol[col_min];
+		for (j = 0; planes && j < n_z; j++) {	/* The same nodes in each z column, one plain loop per grid */
+			Z = Product[TRIANGULATE2_GRID (TRIANGULATE2_Z, j, n_z)];
+			DX = Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDX, j, n_z)];
+			DY = Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDY, j, n_z)];
+			if (Z) for (col = 0, out = &Z->data[p]; col < n; col++) out[col] = (float)(a[j] * x[col] + b[j] * yp + c[j]);
+			if (DX) for (col = 0, out = &DX->data[p]; col < n; col++) out[col] = (float)a[j];
+			if (DY) for (col = 0, out = &DY->data[p]; col < n; col++) out[col] = (float)b[j];
+		}
+		if (Product[TRIANGULATE2_GRID (TRIANGULATE2_SIGMA, 0, n_z)]) {	//CURVE: Uncertainties are done a row span at a time
+			ps = (uint64_t)(row - R->slope_row0) * R->header->n_columns + col_min;
+			R->sigma_span (x, n, yp, vx, vy, uh, uv, &R->tan2_slope[ps], R->alpha, R->delta_min, R->s_H, &Product[TRIANGULATE2_GRID (TRIANGULATE2_SIGMA, 0, n_z)]->data[p]);
+		}
+		if (R->weight) {	/* Remember the barycentric weights for -W+w */
+			struct TRIANGULATE2_WEIGHT *W = &R->weight[(uint64_t)row * R->header->n_columns + col_min];
+			for (col = col_min; col <= col_max; col++, W++) {
+				W->tri = k;
+				W->w[0] = (float)(orient2d (vx[1], vy[1], vx[2], vy[2], R->xcol[col], yp) / orient);
+				W->w[1] = (float)(orient2d (vx[2], vy[2], vx[0], vy[0], R->xcol[col], yp) / orient);
+				W->w[2] = (float)(orient2d (vx[0], vy[0], vx[1], vy[1], R->xcol[col], yp) / orient);
+			}
+		}
+	}
+}
+
+GMT_LOCAL uint64_t *bin_triangles (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, uint64_t *list, uint64_t np, int row_lo, int row_hi, int height, int n_bands, uint64_t **start) {
+	/* Counting sort the np triangles (list[], or 0 to np-1 if list is NULL) into the bands of height
+	 * rows from row_lo down to row_hi that they touch, keeping their order within each band.  Band b
+	 * holds member[start[b]] to member[start[b+1]-1] */
+	int band, row_min, row_max;
+	uint64_t i, k, *member = NULL, *first = NULL;
+
+	first = gmt_M_memory (GMT, NULL, n_bands + 1, uint64_t);
+	for (i = 0; i < np; i++) {
+		k = (list) ? list[i] : i;
+		if (!triangle_rows (GMT, R, k, &row_min, &row_max) || row_max < row_lo || row_min > row_hi) continue;
+		row_min = MAX (row_min, row_lo) - row_lo;	row_max = MIN (row_max, row_hi) - row_lo;
+		for (band = row_min / height; band <= row_max / height; band++) first[band+1]++;
+	}
+	for (band = 0; band < n_bands; band++) first[band+1] += first[band];
+	member = gmt_M_memory (GMT, NULL, MAX (first[n_bands], 1), uint64_t);
+	for (i = 0; i < np; i++) {
+		k = (list) ? list[i] : i;
+		if (!triangle_rows (GMT, R, k, &row_min, &row_max) || row_max < row_lo || row_min > row_hi) continue;
+		row_min = MAX (row_min, row_lo) - row_lo;	row_max = MIN (row_max, row_hi) - row_lo;
+		for (band = row_min / height; band <= row_max / height; band++) member[first[band]++] = k;
+	}
+	for (band = n_bands; band > 0; band--) first[band] = first[band-1];	/* Undo the advance */
+	first[0] = 0;
+	*start = first;
+	return (member);
+}
+
+GMT_LOCAL void grid_triangles (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, uint64_t *list, uint64_t np, int row_lo, int row_hi) {
+	/* Grid the np triangles (list[], or 0 to np-1 if list is NULL) on rows row_lo-row_hi.  Each node
+	 * belongs to one triangle (see closed_edges), except a node on a vertex of the hull, which takes
+	 * the value from the last of its triangles, as in a plain loop over them.  With threads, the rows
+	 * are cut into bands and each band grids its own triangles, in the same order, so the grids do
+	 * not depend on the number of threads. */
+	int n_rows = row_hi - row_lo + 1, n_bands = 1, height = n_rows, band;
+	uint64_t i, *start = NULL, *member = NULL;
+	int n_threads = TRIANGULATE2_THREADS (GMT);
+
+	if (n_threads > 1 && n_rows > 1) {	/* Several bands per thread to even out the load */
+		height = MAX (1, (n_rows + 4 * n_threads - 1) / (4 * n_threads));
+		n_bands = (n_rows + height - 1) / height;
+	}
+	if (n_bands == 1) {
+		for (i = 0; i < np; i++) grid_triangle (GMT, R, (list) ? list[i] : i, row_lo, row_hi);
+		return;
+	}
+
+	member = bin_triangles (GMT, R, list, np, row_lo, row_hi, height, n_bands, &start);
+	GMT_Report (GMT->parent, GMT_MSG_DEBUG, "Grid %" PRIu64 " triangles in %d bands of %d rows\n", np, n_bands, height);
+
+#ifdef _OPENMP
+#pragma omp parallel for private(band,i) shared(GMT,R,start,member,height,row_lo,row_hi,n_bands) schedule(dynamic,1) num_threads(n_threads)
+#endif
+	for (band = 0; band < n_bands; band++) {
+		int lo = row_lo + band * height, hi = MIN (lo + height - 1, row_hi);
+		for (i = start[band]; i < start[band+1]; i++) grid_triangle (GMT, R, member[i], lo, hi);
+	}
+	gmt_M_free (GMT, member);
+	gmt_M_free (GMT, start);
+}
+
+GMT_LOCAL double slope_at (struct GMT_GRID *G, double x, double y) {
+	/* Bilinear interpolation of the slope grid G at (x,y).  Beyond the outer nodes the edge values
+	 * are used, and a NaN node makes the result NaN */
+	struct GMT_GRID_HEADER *h = G->header;
+	int c0, c1, r0, r1, last_c = (int)h->n_columns - 1, last_r = (int)h->n_rows - 1;
+	double fx, fy, wx, wy;
+
+	fx = (x - h->wesn[XLO]) * h->r_inc[GMT_X] - h->xy_off;
+	fy = (h->wesn[YHI] - y) * h->r_inc[GMT_Y] - h->xy_off;
+	fx = MAX (0.0, MIN (fx, (double)last_c));	fy = MAX (0.0, MIN (fy, (double)last_r));
+	c0 = MIN ((int)fx, MAX (last_c - 1, 0));	c1 = MIN (c0 + 1, last_c);	wx = fx - c0;
+	r0 = MIN ((int)fy, MAX (last_r - 1, 0));	r1 = MIN (r0 + 1, last_r);	wy = fy - r0;
+	return ((1.0 - wy) * ((1.0 - wx) * G->data[gmt_M_ijp (h, r0, c0)] + wx * G->data[gmt_M_ijp (h, r0, c1)]) +
+		wy * ((1.0 - wx) * G->data[gmt_M_ijp (h, r1, c0)] + wx * G->data[gmt_M_ijp (h, r1, c1)]));
+}
+
+GMT_LOCAL void apply_weights (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, struct TRIANGULATE2_WEIGHTS *W) {
+	/* Set the grid nodes from saved triangles and weights (-W) instead of rasterizing the triangles.
+	 * z is a weighted sum of the three vertex values; slopes and uncertainties need the whole
+	 * triangle, which is found once for each run of nodes in the same triangle. */
+	int row, col;
+	unsigned int j, n_z = R->n_z;
+	int64_t i;
+	uint64_t p, last = UINT64_MAX, ij[3];
+	double vx[4], vy[4], uh[3], uv[3], a[TRIANGULATE2_MAX_Z], b[TRIANGULATE2_MAX_Z], c[TRIANGULATE2_MAX_Z], yp, *z = NULL;
+	struct TRIANGULATE2_WEIGHT *w = NULL;
+	struct GMT_GRID **Product = R->Product, *G = NULL;
+	bool slopes = (Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDX, 0, n_z)] || Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDY, 0, n_z)]);
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i,j,row,col,p,ij,w,vx,vy,uh,uv,a,b,c,yp,z,G) firstprivate(last) shared(GMT,R,W,Product,n_z,slopes) schedule(static) num_threads(TRIANGULATE2_THREADS (GMT))
+#endif
+	for (i = 0; i < (int64_t)W->H->n_nodes; i++) {
+		w = &W->weight[i];
+		row = (int)(w->node / R->header->n_columns);	col = (int)(w->node % R->header->n_columns);
+		p = gmt_M_ijp (R->header, row, col);
+		if (w->tri != last) {	/* Another triangle */
+			triangle_vertices (R, w->tri, ij, vx, vy, uh, uv);
+			if (slopes) triangle_planes (R, ij, vx, vy, a, b, c);
+			last = w->tri;
+		}
+		for (j = 0; j < n_z; j++) {
+			if ((G = Product[TRIANGULATE2_GRID (TRIANGULATE2_Z, j, n_z)]) != NULL) {
+				z = R->z[j];
+				G->data[p] = (float)(w->w[0] * z[ij[0]] + w->w[1] * z[ij[1]] + w->w[2] * z[ij[2]]);
+			}
+			if ((G = Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDX, j, n_z)]) != NULL) G->data[p] = (float)a[j];
+			if ((G = Product[TRIANGULATE2_GRID (TRIANGULATE2_DZDY, j, n_z)]) != NULL) G->data[p] = (float)b[j];
+		}
+		if ((G = Product[TRIANGULATE2_GRID (TRIANGULATE2_SIGMA, 0, n_z)]) != NULL) {	//CURVE
+			yp = gmt_M_grd_row_to_y (GMT, row, R->header);
+			R->sigma_span (&R->xcol[col], 1, yp, vx, vy, uh, uv, &R->tan2_slope[w->node], R->alpha, R->delta_min, R->s_H, &G->data[p]);
+		}
+	}
+}
+
+GMT_LOCAL int edge_facing (struct TRIANGULATE2_RASTER *R, uint64_t t, double x, double y, unsigned int first) {
+	/* Return an edge k of triangle t (from vertex k to k+1) with (x,y) strictly on its far side, checking
+	 * from edge first on, 3 if the point is inside or on an edge, or -1 if the triangle has no area */
+	unsigned int j, k;
+	uint64_t ij;
+	double vx[4], vy[4], s, o;
+
+	for (j = 0; j < 3; j++) {
+		ij = R->inc * R->link[3*t+j];
+		vx[j] = R->x[ij];	vy[j] = R->y[ij];
+	}
+	vx[3] = vx[0];	vy[3] = vy[0];
+	if ((s = orient2d (vx[0], vy[0], vx[1], vy[1], vx[2], vy[2])) == 0.0) return (-1);
+	for (j = 0; j < 3; j++) {
+		k = (first + j) % 3;
+		o = orient2d (vx[k], vy[k], vx[k+1], vy[k+1], x, y);
+		if ((s > 0.0) ? (o < 0.0) : (o > 0.0)) return ((int)k);
+	}
+	return (3);
+}
+
+#define TRIANGULATE2_JUMP_FILL	4	/* Triangles per cell of the grid of walk starts */
+
+GMT_LOCAL void jump_grid (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R) {
+	/* Lay a grid of about np / TRIANGULATE2_JUMP_FILL cells over the triangle centroids and remember
+	 * a triangle in each cell, so a walk to a point far from the previous one can start nearby */
+	unsigned int j, col, row;
+	uint64_t t, ij, n_cells = MAX (R->np / TRIANGULATE2_JUMP_FILL, 1);
+	double xc, yc, x_max, y_max, w, h;
+
+	if (R->np == 0) return;
+	R->jump_x0 = x_max = R->x[R->inc*R->link[0]];	R->jump_y0 = y_max = R->y[R->inc*R->link[0]];
+	for (t = 1; t < 3 * R->np; t++) {
+		ij = R->inc * R->link[t];
+		R->jump_x0 = MIN (R->jump_x0, R->x[ij]);	x_max = MAX (x_max, R->x[ij]);
+		R->jump_y0 = MIN (R->jump_y0, R->y[ij]);	y_max = MAX (y_max, R->y[ij]);
+	}
+	w = MAX (x_max - R->jump_x0, DBL_MIN);	h = MAX (y_max - R->jump_y0, DBL_MIN);
+	R->jump_nx = (unsigned int)MAX (1.0, MIN (ceil (sqrt (n_cells * w / h)), (double)n_cells));
+	R->jump_ny = (unsigned int)MAX (1, (n_cells + R->jump_nx - 1) / R->jump_nx);
+	R->jump_r_inc[GMT_X] = R->jump_nx / w;	R->jump_r_inc[GMT_Y] = R->jump_ny / h;
+	R->jump_d2 = 1.0 / (R->jump_r_inc[GMT_X] * R->jump_r_inc[GMT_X]) + 1.0 / (R->jump_r_inc[GMT_Y] * R->jump_r_inc[GMT_Y]);
+	R->jump = gmt_M_memory (GMT, NULL, (uint64_t)R->jump_nx * R->jump_ny, uint64_t);
+	for (t = 0; t < (uint64_t)R->jump_nx * R->jump_ny; t++) R->jump[t] = UINT64_MAX;
+	for (t = 0; t < R->np; t++) {
+		for (j = 0, xc = yc = 0.0; j < 3; j++) {
+			ij = R->inc * R->link[3*t+j];
+			xc += R->x[ij];	yc += R->y[ij];
+		}
+		col = (unsigned int)MIN ((xc / 3.0 - R->jump_x0) * R->jump_r_inc[GMT_X], R->jump_nx - 1.0);
+		row = (unsigned int)MIN ((yc / 3.0 - R->jump_y0) * R->jump_r_inc[GMT_Y], R->jump_ny - 1.0);
+		R->jump[(uint64_t)row * R->jump_nx + col] = t;
+	}
+}
+
+GMT_LOCAL uint64_t find_triangle (struct TRIANGULATE2_RASTER *R, double x, double y, uint64_t t, uint64_t *n_scan) {
+	/* Find the triangle holding (x,y) by walking from triangle t, each time across an edge that has the
+	 * point on its far side.  If t is more than a cell of the jump grid away, the walk starts from the
+	 * triangle of the point's cell instead.  The first edge checked changes from step to step so the
+	 * walk cannot go in circles.  The hull is convex, so once the point is beyond a hull edge it is
+	 * outside.  A walk that is held up by a triangle without area, or goes on too long, falls back on
+	 * trying them all, and adds one to *n_scan.  Returns UINT64_MAX if the point is outside. */
+	int k;
+	uint64_t step, ij;
+	double dx, dy, col, row;
+
+	if (R->np == 0 || gmt_M_is_dnan (x) || gmt_M_is_dnan (y)) return (UINT64_MAX);
+	if (t >= R->np) t = 0;
+	ij = R->inc * R->link[3*t];
+	dx = x - R->x[ij];	dy = y - R->y[ij];
+	if (R->jump && dx * dx + dy * dy > R->jump_d2) {	/* Far away; jump closer if we can */
+		col = MAX (0.0, MIN ((x - R->jump_x0) * R->jump_r_inc[GMT_X], R->jump_nx - 1.0));
+		row = MAX (0.0, MIN ((y - R->jump_y0) * R->jump_r_inc[GMT_Y], R->jump_ny - 1.0));
+		if ((ij = R->jump[(uint64_t)row * R->jump_nx + (uint64_t)col]) != UINT64_MAX) t = ij;
+	}
+	for (step = 0; step < R->np; step++) {
+		if ((k = edge_facing (R, t, x, y, (unsigned int)(step % 3))) < 0) break;
+		if (k == 3) return (t);
+		if ((t = R->neighbor[3*t+k]) == UINT64_MAX) return (UINT64_MAX);
+	}
+	(*n_scan)++;
+	for (t = 0; t < R->np; t++) if (edge_facing (R, t, x, y, 0) == 3) return (t);
+	return (UINT64_MAX);
+}
+
+GMT_LOCAL void query_points (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, double *xq, double *yq, uint64_t nq, uint64_t *last, double empty, double *answer) {
+	/* Interpolate at the nq points (xq,yq), setting one row of answer per point to x, y, each z and,
+	 * with a slope grid, the CURVE uncertainty (empty outside the hull).  Each thread takes a run of
+	 * consecutive points and walks from one to the next, starting at triangle *last, which is then
+	 * set to the triangle of the final point for the next call. */
+	int n_threads = 1, run;
+	unsigned int n_out = 2 + R->n_z + (R->Slopes != NULL);
+	uint64_t first = *last, final = UINT64_MAX, n_scan = 0;	/* Only the last run sets final */
+
+#ifdef _OPENMP
+	if (nq >= TRIANGULATE2_MIN_RUN) n_threads = (int)MIN ((uint64_t)TRIANGULATE2_THREADS (GMT), nq / TRIANGULATE2_MIN_RUN);
+#pragma omp parallel for private(run) shared(GMT,R,xq,yq,nq,first,final,empty,answer,n_out,n_threads) reduction(+:n_scan) schedule(static,1) num_threads(n_threads)
+#endif
+	for (run = 0; run < n_threads; run++) {
+		unsigned int j;
+		uint64_t i, k, t = first, now = UINT64_MAX, ij[3];
+		uint64_t begin = nq * run / n_threads, end = nq * (run + 1) / n_threads;
+		double vx[4], vy[4], uh[3], uv[3], a[TRIANGULATE2_MAX_Z], b[TRIANGULATE2_MAX_Z], c[TRIANGULATE2_MAX_Z], t2, *row = NULL;
+		float sigma;
+
+		for (i = begin; i < end; i++) {
+			row = &answer[i*n_out];
+			row[GMT_X] = xq[i];	row[GMT_Y] = yq[i];
+			if ((k = find_triangle (R, xq[i], yq[i], t, &n_scan)) == UINT64_MAX) {	/* Outside */
+				for (j = GMT_Z; j < n_out; j++) row[j] = empty;
+				continue;
+			}
+			if (k != now) {	/* Another triangle */
+				triangle_vertices (R, k, ij, vx, vy, uh, uv);
+				triangle_planes (R, ij, vx, vy, a, b, c);
+				t = now = k;
+			}
+			for (j = 0; j < R->n_z; j++) row[GMT_Z+j] = a[j] * xq[i] + b[j] * yq[i] + c[j];
+			if (R->Slopes) {	//CURVE
+				t2 = tan (slope_at (R->Slopes, xq[i], yq[i]));	t2 *= t2;
+				R->sigma_span (&xq[i], 1, yq[i], vx, vy, uh, uv, &t2, R->alpha, R->delta_min, R->s_H, &sigma);
+				row[GMT_Z+R->n_z] = sigma;
+			}
+		}
+		if (run == n_threads - 1) final = now;
+	}
+	if (final != UINT64_MAX) *last = final;
+	if (n_scan) GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "%" PRIu64 " of %" PRIu64 " query points were found by trying every triangle\n", n_scan, nq);
+}
+
+GMT_LOCAL bool serve_queries (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, FILE *fp_in, FILE *fp_out, uint64_t *last, double empty) {
+	/* Answer batches of x y query lines from fp_in until end of file or a quit line (-C+s|u).  A batch
+	 * ends at a blank line or end of file; its answers, as with -C<queryfile>, are written to fp_out
+	 * followed by a blank line and flushed at once.  Lines starting with # or > are skipped and lines
+	 * that cannot be read, or are longer than GMT_BUFSIZ, give one empty answer.  Returns true if
+	 * asked to quit. */
+	bool quit = false, eof = false, too_long;
+	int ch;
+	unsigned int col, n_out = 2 + R->n_z + (R->Slopes != NULL), toggle_in, toggle_out;
+	uint64_t row, n = 0, n_alloc = 0, n_answer = 0;
+	double *xq = NULL, *yq = NULL, *answer = NULL, in[2];
+	char line[GMT_BUFSIZ] = {""}, word[2][GMT_BUFSIZ], *c = NULL;
+
+	toggle_in = GMT->current.setting.io_lonlat_toggle[GMT_IN];
+	toggle_out = GMT->current.setting.io_lonlat_toggle[GMT_OUT];
+	while (!quit && !eof) {
+		if (!(eof = (fgets (line, GMT_BUFSIZ, fp_in) == NULL))) {
+			if ((too_long = (strlen (line) == GMT_BUFSIZ - 1 && line[GMT_BUFSIZ-2] != '\n'))) {	/* Skip the rest so it stays one query */
+				while ((ch = fgetc (fp_in)) != EOF && ch != '\n');
+				GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Warning: Query line longer than %d characters gets an empty answer\n", GMT_BUFSIZ - 2);
+			}
+			gmt_chop (line);
+			for (c = line; *c == ' ' || *c == '\t'; c++);
+			if (*c == '#' || *c == '>') continue;
+			if (!strcmp (c, "quit"))
+				quit = true;
+			else if (*c) {	/* Another query point */
+				if (n == n_alloc) {
+					n_alloc = (n_alloc) ? 2 * n_alloc : GMT_CHUNK;
+					xq = gmt_M_memory (GMT, xq, n_alloc, double);
+					yq = gmt_M_memory (GMT, yq, n_alloc, double);
+				}
+				for (; *c; c++) if (*c == ',') *c = ' ';
+				in[GMT_X] = in[GMT_Y] = GMT->session.d_NaN;
+				if (!too_long && sscanf (line, "%s %s", word[GMT_X], word[GMT_Y]) == 2) {
+					for (col = 0; col < 2; col++)
+						if (gmt_scanf (GMT, word[col], GMT->current.io.col_type[GMT_IN][col], &in[col]) == GMT_IS_NAN) in[col] = GMT->session.d_NaN;
+				}
+				xq[n] = in[toggle_in];	yq[n++] = in[1-toggle_in];
+				continue;
+			}
+		}
+		if (n == 0 && (eof || quit)) break;	/* Nothing asked */
+		if (n > n_answer) answer = gmt_M_memory (GMT, answer, (n_answer = n_alloc) * n_out, double);
+		if (n) query_points (GMT, R, xq, yq, n, last, empty, answer);
+		for (row = 0; row < n; row++) {
+			for (col = 0; col < n_out; col++) {
+				gmt_ascii_output_col (GMT, fp_out, answer[row*n_out+((col < 2 && toggle_out) ? 1 - col : col)], col);
+				fputs ((col < n_out - 1) ? GMT->current.setting.io_col_separator : "\n", fp_out);
+			}
+		}
+		fputs ("\n", fp_out);	/* End of the answers to this batch */
+		fflush (fp_out);
+		n = 0;
+	}
+	gmt_M_free (GMT, xq);
+	gmt_M_free (GMT, yq);
+	gmt_M_free (GMT, answer);
+	return (quit);
+}
+
+#ifndef WIN32
+GMT_LOCAL int serve_socket (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, char *path, uint64_t *last, double empty) {
+	/* Listen on the Unix socket path and serve one client at a time with serve_queries until one
+	 * of them says quit.  A client that hangs up early must not take the server down with it.  Any
+	 * client may say quit, so only the owner may connect. */
+	int fd, client;
+	int status = GMT_NOERROR;
+	bool quit = false, failed;
+	FILE *fp_in = NULL, *fp_out = NULL;
+	struct sockaddr_un addr;
+	struct stat buf;
+	mode_t mask;
+	void (*pipe_handler) (int);
+
+	if (strlen (path) >= sizeof (addr.sun_path)) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Socket name %s is too long\n", path);
+		return (GMT_RUNTIME_ERROR);
+	}
+	gmt_M_memset (&addr, 1, struct sockaddr_un);
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, path);
+	if (!lstat (path, &buf)) {	/* Only remove a socket, left over from a server that was killed */
+		if (!S_ISSOCK (buf.st_mode)) {
+			GMT_Report (GMT->parent, GMT_MSG_NORMAL, "%s exists and is not a socket; will not replace it\n", path);
+			return (GMT_RUNTIME_ERROR);
+		}
+		unlink (path);
+	}
+	mask = umask (S_IXUSR | S_IRWXG | S_IRWXO);	/* Create the socket as 0600 so no one else can connect in the meantime */
+	failed = ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0 || bind (fd, (struct sockaddr *)&addr, sizeof (addr)));
+	umask (mask);
+	if (failed || listen (fd, 8)) {
+		GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Cannot listen on socket %s\n", path);
+		if (fd >= 0) close (fd);
+		return (GMT_ERROR_ON_FOPEN);
+	}
+	pipe_handler = signal (SIGPIPE, SIG_IGN);
+	GMT_Report (GMT->parent, GMT_MSG_VERBOSE, "Serve queries on socket %s\n", path);
+	while (!quit) {
+		if ((client = accept (fd, NULL, NULL)) < 0) {
+			GMT_Report (GMT->parent, GMT_MSG_NORMAL, "Cannot accept clients on socket %s\n", path);
+			status = GMT_RUNTIME_ERROR;
+			break;
+		}
+		if ((fp_in = fdopen (client, "r")) == NULL || (fp_out = fdopen (dup (client), "w")) == NULL) {
+			if (fp_in) fclose (fp_in); else close (client);
+			continue;
+		}
+		quit = serve_queries (GMT, R, fp_in, fp_out, last, empty);
+		fclose (fp_in);
+		fclose (fp_out);
+	}
+	signal (SIGPIPE, pipe_handler);
+	close (fd);
+	unlink (path);
+	return (status);
+}
+#endif
+
+GMT_LOCAL int write_answers (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, struct GMT_DATASET *D, uint64_t *last, double empty) {
+	/* Interpolate at the points of each segment of D and write the answers (-C).  Output must be on */
+	unsigned int n_out = 2 + R->n_z + (R->Slopes != NULL);
+	uint64_t tbl, seg, row, n_alloc = 0;
+	double *answer = NULL;
+	struct GMT_DATASEGMENT *S = NULL;
+	struct GMTAPI_CTRL *API = GMT->parent;
 
-#define GMT_PROG_OPTIONS "-:>JRVbdfhirs" GMT_OPT("FHm")
-//#define GMT_PROG_OPTIONS "-:>RVabfghior" "H"	/* The H is for possible compatibility with GMT4 syntax */
+	for (tbl = 0; tbl < D->n_tables; tbl++) {
+		for (seg = 0; seg < D->table[tbl]->n_segments; seg++) {
+			S = D->table[tbl]->segment[seg];
+			if (S->n_rows > n_alloc) answer = gmt_M_memory (GMT, answer, (n_alloc = S->n_rows) * n_out, double);
+			query_points (GMT, R, S->coord[GMT_X], S->coord[GMT_Y], S->n_rows, last, empty, answer);
+			if (D->n_segments > 1 && GMT_Put_Record (API, GMT_WRITE_SEGMENT_HEADER, S->header)) {
+				gmt_M_free (GMT, answer);
+				return (API->error);
+			}
+			for (row = 0; row < S->n_rows; row++) {
+				if (GMT_Put_Record (API, GMT_WRITE_DOUBLE, &answer[row*n_out])) {
+					gmt_M_free (GMT, answer);
+					return (API->error);
+				}
+			}
+		}
+	}
+	gmt_M_free (GMT, answer);
+	return (GMT_NOERROR);
+}
 
-static double EPS_D = 2.220446e-16;
+GMT_LOCAL int read_slopes (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, int row_lo, int row_hi) {
+	/* Read the part of the slope grid under grid rows row_lo-row_hi and keep the tangent of the
+	 * slope squared at each of their nodes in R->tan2_slope, replacing the rows read before, so the
+	 * kernels do no trigonometry.  A slope grid on the same lattice as the output grid is used as is;
+	 * any other is interpolated bilinearly. */
+	bool same;
+	int row, col, c_off, r_off, n_columns = (int)R->header->n_columns;
+	uint64_t p;
+	double wesn[4], x_off, y_off, t;
+	struct GMTAPI_CTRL *API = GMT->parent;
+	struct GMT_GRID_HEADER *h = R->header, *S = NULL;
+	struct GMT_GRID *Slopes = NULL;
+
+	if ((Slopes = GMT_Read_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_HEADER_ONLY, NULL, R->slope_file, NULL)) == NULL)
+		return (API->error);
+	S = Slopes->header;
+	x_off = (h->wesn[XLO] + h->xy_off * h->inc[GMT_X] - S->wesn[XLO] - S->xy_off * S->inc[GMT_X]) * S->r_inc[GMT_X];	/* First node, in slope nodes */
+	y_off = (S->wesn[YHI] - S->xy_off * S->inc[GMT_Y] - h->wesn[YHI] + h->xy_off * h->inc[GMT_Y]) * S->r_inc[GMT_Y];
+	same = (fabs (S->inc[GMT_X] - h->inc[GMT_X]) < GMT_CONV8_LIMIT * h->inc[GMT_X] && fabs (S->inc[GMT_Y] - h->inc[GMT_Y]) < GMT_CONV8_LIMIT * h->inc[GMT_Y] &&
+		fabs (x_off - rint (x_off)) < GMT_CONV8_LIMIT && fabs (y_off - rint (y_off)) < GMT_CONV8_LIMIT);
+	wesn[XLO] = h->wesn[XLO];	wesn[XHI] = h->wesn[XHI];
+	wesn[YHI] = h->wesn[YHI] - row_lo * h->inc[GMT_Y];
+	wesn[YLO] = wesn[YHI] - (row_hi - row_lo + (int)h->registration) * h->inc[GMT_Y];
+	if (wesn[XLO] < S->wesn[XLO] - GMT_CONV8_LIMIT * h->inc[GMT_X] || wesn[XHI] > S->wesn[XHI] + GMT_CONV8_LIMIT * h->inc[GMT_X] ||
+	    wesn[YLO] < S->wesn[YLO] - GMT_CONV8_LIMIT * h->inc[GMT_Y] || wesn[YHI] > S->wesn[YHI] + GMT_CONV8_LIMIT * h->inc[GMT_Y]) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Slope grid %s does not cover the -R region\n", R->slope_file);
+		GMT_Destroy_Data (API, &Slopes);
+		return (GMT_RUNTIME_ERROR);
+	}
+	if (same && S->registration != h->registration) {	/* Same lattice, but the read window must follow the slope grid's registration */
+		double dx = (h->registration == GMT_GRID_PIXEL_REG) ? 0.5 * h->inc[GMT_X] : -0.5 * h->inc[GMT_X];
+		double dy = (h->registration == GMT_GRID_PIXEL_REG) ? 0.5 * h->inc[GMT_Y] : -0.5 * h->inc[GMT_Y];
+		wesn[XLO] += dx;	wesn[XHI] -= dx;	wesn[YLO] += dy;	wesn[YHI] -= dy;
+	}
+	else if (!same) {	/* Take a slope node more on all sides for the interpolation */
+		wesn[XLO] = MAX (wesn[XLO] - S->inc[GMT_X], S->wesn[XLO]);	wesn[XHI] = MIN (wesn[XHI] + S->inc[GMT_X], S->wesn[XHI]);
+		wesn[YLO] = MAX (wesn[YLO] - S->inc[GMT_Y], S->wesn[YLO]);	wesn[YHI] = MIN (wesn[YHI] + S->inc[GMT_Y], S->wesn[YHI]);
+		GMT_Report (API, GMT_MSG_LONG_VERBOSE, "Slope grid %s is not on the output lattice; interpolate it bilinearly\n", R->slope_file);
+	}
+	if (GMT_Read_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_DATA_ONLY, wesn, R->slope_file, Slopes) == NULL) {
+		int error = API->error;
+		GMT_Destroy_Data (API, &Slopes);
+		return (error);
+	}
 
-struct TRIANGULATE2_CTRL {
-	struct D {	/* -Dx|y */
-		bool active;
-		unsigned int dir;
-	} D;
-	struct E {	/* -E<value> */
-		bool active;
-		double value;
-	} E;
-	struct G {	/* -G<output_grdfile> */
-		bool active;
-		char *file;
-	} G;
-	struct I {	/* -Idx[/dy] */
-		bool active;
-		double inc[2];
-	} I;
-	struct M {	/* -M */
-		bool active;
-	} M;
-	struct N {	/* -N */
-		bool active;
-	} N;
-	struct Q {	/* -Q */
-		bool active;
-	} Q;
-	struct S {	/* -S */
-		bool active;
-	} S;
-	//CURVE
-	struct u {	/* -u<input_Slopes> */
-		bool active;
-		char *file;
-	} u;
-	struct Z {	/* -Z */
-		bool active;
-	} Z;
-};
+	R->tan2_slope = gmt_M_memory (GMT, R->tan2_slope, (size_t)(row_hi - row_lo + 1) * n_columns, double);
+	R->slope_row0 = row_lo;
+	c_off = (int)lrint ((h->wesn[XLO] + h->xy_off * h->inc[GMT_X] - S->wesn[XLO] - S->xy_off * S->inc[GMT_X]) * S->r_inc[GMT_X]);	/* Now in the window read */
+	r_off = (int)lrint ((S->wesn[YHI] - S->xy_off * S->inc[GMT_Y] - h->wesn[YHI] + h->xy_off * h->inc[GMT_Y]) * S->r_inc[GMT_Y]);
+#ifdef _OPENMP
+#pragma omp parallel for private(row,col,p,t) shared(GMT,R,Slopes,S,h,same,c_off,r_off,row_lo,row_hi,n_columns) num_threads(TRIANGULATE2_THREADS (GMT))
+#endif
+	for (row = row_lo; row <= row_hi; row++) {	/* Output node (row,col) is node (row + r_off, col + c_off) of the slope window if on the same lattice */
+		p = (uint64_t)(row - row_lo) * n_columns;
+		for (col = 0; col < n_columns; col++, p++) {
+			t = tan ((same) ? (double)Slopes->data[gmt_M_ijp (S, row + r_off, col + c_off)] : slope_at (Slopes, R->xcol[col], gmt_M_grd_row_to_y (GMT, row, h)));
+			R->tan2_slope[p] = t * t;
+		}
+	}
+	return (GMT_Destroy_Data (API, &Slopes));
+}
 
-struct TRIANGULATE2_EDGE {
-	unsigned int begin, end;
-};
+GMT_LOCAL int grid_tiles (struct GMT_CTRL *GMT, struct TRIANGULATE2_RASTER *R, uint64_t np, int height, float empty) {
+	/* Grid the np triangles a tile of height rows at a time and write each tile as it is done.  The
+	 * grids have been opened for row-by-row output and their data arrays hold a single tile.  As the
+	 * rows go out we keep the range of each grid in its header, for the caller to write back. */
+	int tile, n_tiles, row, lo, hi, n_rows = (int)R->header->n_rows, error;
+	unsigned int k, col, n_grids = TRIANGULATE2_N_PRODUCTS * R->n_z;
+	uint64_t p, *start = NULL, *member = NULL;
+	size_t size = (size_t)(height + R->header->pad[YHI] + R->header->pad[YLO]) * R->header->mx;
+	float *z = NULL;
+	struct GMT_GRID_HEADER *h = NULL;
+
+	n_tiles = (n_rows + height - 1) / height;
+	member = bin_triangles (GMT, R, NULL, np, 0, n_rows - 1, height, n_tiles, &start);
+	GMT_Report (GMT->parent, GMT_MSG_LONG_VERBOSE, "Grid %" PRIu64 " triangles in %d tiles of %d rows\n", np, n_tiles, height);
+	for (k = 0; k < n_grids; k++) {
+		if (!R->Product[k]) continue;
+		R->Product[k]->header->z_min = DBL_MAX;	R->Product[k]->header->z_max = -DBL_MAX;
+	}
+	for (tile = 0; tile < n_tiles; tile++) {
+		lo = tile * height;	hi = MIN (lo + height, n_rows) - 1;
+		for (k = 0; k < n_grids; k++) {
+			if (!R->Product[k]) continue;
+			for (p = 0; p < size; p++) R->Product[k]->data[p] = empty;
+		}
+		R->row0 = lo;
+		if (R->slope_file && (error = read_slopes (GMT, R, lo, hi)) != GMT_NOERROR) {	/* CURVE: Just the slopes of this tile */
+			gmt_M_free (GMT, member);
+			gmt_M_free (GMT, start);
+			return (error);
+		}
+		grid_triangles (GMT, R, &member[start[tile]], start[tile+1] - start[tile], lo, hi);
+		for (row = lo; row <= hi; row++) {
+			for (k = 0; k < n_grids; k++) {
+				if (!R->Product[k]) continue;
+				h = R->Product[k]->header;
+				z = &R->Product[k]->data[gmt_M_ijp (R->header, row - lo, 0)];
+				for (col = 0; col < h->n_columns; col++) {
+					if (gmt_M_is_fnan (z[col])) continue;
+					if (z[col] < h->z_min) h->z_min = z[col];
+					if (z[col] > h->z_max) h->z_max = z[col];
+				}
+				if (GMT_Put_Row (GMT->parent, row, R->Product[k], z)) {
+					gmt_M_free (GMT, member);
+					gmt_M_free (GMT, start);
+					return (GMT->parent->error);
+				}
+			}
+		}
+	}
+	for (k = 0; k < n_grids; k++) {
+		if (!R->Product[k] || R->Product[k]->header->z_min <= R->Product[k]->header->z_max) continue;
+		R->Product[k]->header->z_min = R->Product[k]->header->z_max = GMT->session.d_NaN;	/* All empty */
+	}
+	R->row0 = 0;
+	gmt_M_free (GMT, member);
+	gmt_M_free (GMT, start);
+	return (GMT_NOERROR);
+}
 
-GMT_LOCAL int compare_edge (const void *p1, const void *p2) {
-	const struct TRIANGULATE2_EDGE *a = p1, *b = p2;
+GMT_LOCAL char *next_modifier (char *arg, char *codes) {
+	/* Return the next +<code><arg> modifier in an option argument, or NULL.  Any other +<string>,
+	 * such as the +s<scale> of a grid name suffix in -G, belongs to the file name before it. */
+	char *c = NULL;
 
-	if (a->begin < b->begin) return (-1);
-	if (a->begin > b->begin) return (+1);
-	if (a->end < b->end) return (-1);
-	if (a->end > b->end) return (+1);
-	return (0);
+	for (c = strchr (arg, '+'); c; c = strchr (&c[1], '+'))
+		if (c[1] && strchr (codes, c[1]) && c[2]) return (c);
+	return (NULL);
 }
 
-enum curve_enum {	/* Indices for coeff array for normalization */
-	GMT_H = GMT_Z + 1	,	/* Index into input/output rows */
-	GMT_V,
-	GMT_U = GMT_H
-};
+GMT_LOCAL bool get_number (char *text, double *value) {
+	/* Convert the argument of a modifier that must be a number and nothing else, unlike atof */
+	char *end = NULL;
+
+	*value = strtod (text, &end);
+	return (end != text && *end == '\0');
+}
+
+GMT_LOCAL bool get_count (char *text, uint64_t max, uint64_t *value) {
+	/* Convert an argument that must be a whole number from 1 to max and nothing else, unlike atoi
+	 * and strtoull, which take signs, wrap negative numbers around and stop at trailing junk */
+	char *end = NULL;
+
+	if (text[0] < '0' || text[0] > '9') return (false);
+	errno = 0;
+	*value = strtoull (text, &end, 10);
+	return (*end == '\0' && errno == 0 && *value >= 1 && *value <= max);
+}
+
+GMT_LOCAL bool is_template (char *name) {
+	/* True if name is a grid name template with exactly one integer conversion %d, with an optional
+	 * width such as %03d, and no other % but %%, since grid_file hands it to snprintf */
+	unsigned int n_int = 0;
+	char *c = NULL;
+
+	for (c = name; *c; c++) {
+		if (*c != '%') continue;
+		if (*(++c) == '%') continue;	/* A literal % */
+		while (*c >= '0' && *c <= '9') c++;	/* Width */
+		if (*c != 'd') return (false);
+		n_int++;
+	}
+	return (n_int == 1);
+}
 
 GMT_LOCAL void *New_Ctrl (struct GMT_CTRL *GMT) {	/* Allocate and initialize a new control structure */
 	struct TRIANGULATE2_CTRL *C = NULL;
@@ -111,44 +2921,102 @@ GMT_LOCAL void *New_Ctrl (struct GMT_CTRL *GMT) {	/* Allocate and initialize a n
 	
 	/* Initialize values whose defaults are not 0/false/NULL */
 	C->D.dir = 2;	/* No derivatives */
+	C->u.alpha = 2.0;	C->u.s_H = 1.0;	//CURVE
+	C->Z.n_z = 1;
 	return (C);
 }
 
 GMT_LOCAL void Free_Ctrl (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *C) {	/* Deallocate control structure */
+	unsigned int k;
 	if (!C) return;
+	gmt_M_str_free (C->C.file);
+	gmt_M_str_free (C->C.socket);
 	gmt_M_str_free (C->G.file);	
+	for (k = 0; k < TRIANGULATE2_N_PRODUCTS; k++) gmt_M_str_free (C->G.product[k]);
+	gmt_M_str_free (C->u.file);	
+	gmt_M_str_free (C->L.file);
+	gmt_M_str_free (C->W.file);
 	gmt_M_free (GMT, C);	
 }
 
 GMT_LOCAL int usage (struct GMTAPI_CTRL *API, int level) {
 	gmt_show_name_and_purpose (API, THIS_MODULE_LIB, THIS_MODULE_NAME, THIS_MODULE_PURPOSE);
 	if (level == GMT_MODULE_PURPOSE) return (GMT_NOERROR);
-	GMT_Message (API, GMT_TIME_NONE, "usage: triangulate2 [<table>] [-Dx|y] [-E<empty>] [-G<outgrid>] [-u<in_slopes>] \n");
-	GMT_Message (API, GMT_TIME_NONE, "\t[%s] [%s] [-M] [-N] [-Q]\n", GMT_I_OPT, GMT_J_OPT);
-	GMT_Message (API, GMT_TIME_NONE, "\t[%s] [-S] [%s] [-Z] [%s] [%s]\n\t[%s] [%s]\n\t[%s] [%s] [%s] [%s]\n\n",
-		GMT_Rgeo_OPT, GMT_V_OPT, GMT_b_OPT, GMT_d_OPT, GMT_f_OPT, GMT_h_OPT, GMT_i_OPT, GMT_r_OPT, GMT_s_OPT, GMT_colon_OPT);
+	GMT_Message (API, GMT_TIME_NONE, "usage: triangulate2 [<table>] [-A[b|m|r][+n<rows>][+s[h|m]]] [-C<queryfile>|+s|+u<socket>] [-Dx|y] [-E<empty>] [-G[<outgrid>][+x<grid>][+y<grid>][+z<grid>][+u<grid>][+t<rows>]] [-u<in_slopes>[+a<alpha>][+d<delta_min>][+h<s_H>]] \n");
+	GMT_Message (API, GMT_TIME_NONE, "\t[%s] [%s] [-L<tinfile>[+w]] [-M] [-N[+n]] [-Q]\n", GMT_I_OPT, GMT_J_OPT);
+	GMT_Message (API, GMT_TIME_NONE, "\t[%s] [-S] [-Tg|i|p] [%s] [-W<weightfile>[+w]] [-Z[<nz>]] [%s] [%s]\n\t[%s] [%s]\n\t[%s] [%s] [%s] %s[%s]\n\n",
+		GMT_Rgeo_OPT, GMT_V_OPT, GMT_b_OPT, GMT_d_OPT, GMT_f_OPT, GMT_h_OPT, GMT_i_OPT, GMT_r_OPT, GMT_s_OPT, GMT_x_OPT, GMT_colon_OPT);
 
 	if (level == GMT_SYNOPSIS) return (GMT_MODULE_SYNOPSIS);
 
 	GMT_Message (API, GMT_TIME_NONE, "\tOPTIONS:\n");
 	GMT_Option (API, "<");   
+	GMT_Message (API, GMT_TIME_NONE, "\t-A Select how the input table is read.  Append a directive:\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     b: Read the whole table at once and triangulate and grid straight from its columns.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     m: Memory-map a single native double precision binary file (-bi<n>d) and use its\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t        records in place.  Other input is read record-by-record.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     r: Read the table record-by-record.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   [Default parses a single plain ASCII file with all threads (see -x), else as -Ar].\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +n<rows> to state how many records to expect when reading record-by-record;\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   otherwise we estimate it from the size of binary files or the lines at the start of ASCII files.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +s to reorder the points along a Hilbert (+sh) [Default] or Morton (+sm) curve\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   before triangulation.  Reported vertex indices still refer to the input records.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   With -Am only the points handed to the triangulator are reordered, so the mapping is kept.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t-C Interpolate at the (x,y) points in <queryfile> instead and write (x,y,z) records, with a z\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   for each column of -Z<nz> and the propagated uncertainty last if -u is set.  Each point is\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   found by walking the triangles from the one before, so points in track order are fastest.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Points outside the triangulation get the -E value.  Cannot be used with -G, -M, -N, -Q, -S.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Give +s instead to keep the triangulation in memory and answer batches of x y lines from\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   standard input, or +u<socket> to answer clients of a Unix socket one at a time.  A batch\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   ends at a blank line; its answers are written at once and followed by a blank line.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   A line with quit stops the server.  The socket is made readable and writable by its owner\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   only, since any client that can connect may stop it; an existing file that is not a socket\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   is left alone and the server does not start.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-D Take derivative in the x- or y-direction (only with -G) [Default is z value].\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-E Value to use for empty nodes [Default is NaN].\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-G Grid data. Give name of output grid file and specify -R -I.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   It holds z, or dz/dx or dz/dy with -D, or the propagated uncertainty with -u.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +x<grid>, +y<grid>, +z<grid> and/or +u<grid> to also write dz/dx, dz/dy, z and/or\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   the uncertainty (requires -u) from the same pass.  The main grid name may then be omitted.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +t<rows> to grid and write tiles of <rows> rows at a time, so that only one tile\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   of each grid is in memory.  Needs a grid format that can be written row by row.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t   Cannot be used with -N, -Q, -S.\n");
-	GMT_Message (API, GMT_TIME_NONE, "\t   Must be used with -u.\n");
 	GMT_Option (API, "I,J-");   
+	GMT_Message (API, GMT_TIME_NONE, "\t-L Use the triangulation saved in the binary TIN file <tinfile> instead of triangulating.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   The input points must be the same as when it was saved (e.g., only z may change).\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +w to triangulate as usual and save the result, with its neighbor table, to <tinfile> instead.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-M Output triangle edges as multiple segments separated by segment headers.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t   [Default is to output the indices of vertices for each Delaunay triangle].\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-N Write indices of vertices to stdout when -G is used [only write the grid].\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +n to add the three neighbor triangles of each triangle (-1 across the hull);\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   neighbor k shares the edge from vertex k to vertex k+1 (mod 3).\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-Q Compute Voronoi polygon edges instead (requires -R and Shewchuk algorithm) [Delaunay triangulation].\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-S Output triangle polygons as multiple segments separated by segment headers.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t   Cannot be used with -Q.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t-T Select the Delaunay triangulation engine:\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     g: The GMT library (Watson or Shewchuk, see GMT_TRIANGULATE) [Default].\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     i: Built-in incremental engine with exact predicates.  Much faster than Watson\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t        and not limited to 2^31 points.  Duplicate points are ignored.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t     p: As i, but split the points into vertical slabs triangulated by separate threads\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t        (see -x) and stitch them together.  Gives a Delaunay triangulation\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t        of the same points, which may pick other diagonals where four or more are cocircular.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-u Compute propagated uncertainty. Give name of output grid slopes file. Expect (x,y,h,v) or (x,y,z,h,v) on input.\n"); //CURVE
+	GMT_Message (API, GMT_TIME_NONE, "\t   The vertical uncertainty of a vertex grows with distance d as 1 + ((d + s_H * h) / delta_min)^alpha.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +a<alpha> [2], +d<delta_min> [x increment] and +h<s_H> [1] to change the model.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Integer alphas 1-3 are fastest.  Only the part of the slope grid inside -R (or inside each\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   tile with -G+t) is read; if its nodes are not those of the output it is interpolated bilinearly.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t-W Grid with the triangles and barycentric node weights saved in <weightfile> instead of\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   triangulating and rasterizing (requires -G).  The input x,y and -R -I must be the same as\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   when it was saved; only z (and h,v) may change.  Cannot be used with -L or -G+t.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append +w to grid as usual and save the weights to <weightfile> instead.\n");
 	GMT_Message (API, GMT_TIME_NONE, "\t-Z Expect (x,y,z) data on input (and output); automatically set if -G is used [Expect (x,y) data].\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Append <nz> to read <nz> z columns (e.g., one per epoch) after x,y and grid them all from\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   one triangulation and rasterization.  The z, dz/dx and dz/dy grid names in -G must then\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   be templates such as z_%%03d.nc, and we write one grid per z column numbered from 0.\n");
+	GMT_Message (API, GMT_TIME_NONE, "\t   Other output only reports the first z column.\n");
 	GMT_Option (API, "R,V,bi2");
 	GMT_Message (API, GMT_TIME_NONE, "\t-bo Write binary (double) index table [Default is ASCII i/o].\n");
-	GMT_Option (API, "d,f,h,i,r,s,:,.");
+	GMT_Option (API, "d,f,h,i,r,s,x,:,.");
 	
 	return (GMT_MODULE_USAGE);
 }
@@ -160,7 +3028,8 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 	 * returned when registering these sources/destinations with the API.
 	 */
 
-	unsigned int n_errors = 0;
+	unsigned int n_errors = 0, n_files = 0;
+	char *c = NULL;
 	struct GMT_OPTION *opt = NULL;
 	struct GMTAPI_CTRL *API = GMT->parent;
 
@@ -169,10 +3038,78 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 
 			case '<':	/* Skip input files */
 				if (!gmt_check_filearg (GMT, '<', opt->arg, GMT_IN, GMT_IS_DATASET)) n_errors++;
+				n_files++;
 				break;
 
 			/* Processes program-specific parameters */
 
+			case 'A':
+				Ctrl->A.active = true;
+				if ((c = strchr (opt->arg, '+')) != NULL) {	/* Process the modifiers */
+					char *m = NULL, *next = NULL;
+					for (m = c; m; m = strchr (&m[1], '+')) {
+						switch (m[1]) {
+							case 'n':	/* Number of records to expect */
+								if ((next = strchr (&m[2], '+')) != NULL) next[0] = '\0';
+								if (!get_count (&m[2], UINT64_MAX, &Ctrl->A.n_rows)) {
+									GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -A option: +n requires a positive number of records\n");
+									n_errors++;
+								}
+								if (next) next[0] = '+';
+								break;
+							case 's':	/* Order points along a space-filling curve */
+								if (m[2] == 'm')
+									Ctrl->A.sort = TRIANGULATE2_SORT_MORTON;
+								else if (m[2] == 'h' || m[2] == '\0' || m[2] == '+')
+									Ctrl->A.sort = TRIANGULATE2_SORT_HILBERT;
+								else {
+									GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -A option: Give +sh or +sm\n");
+									n_errors++;
+								}
+								break;
+							default:
+								GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -A option: Unrecognized modifier +%c\n", m[1]);
+								n_errors++;
+								break;
+						}
+					}
+					c[0] = '\0';	/* Chop off modifiers */
+				}
+				switch (opt->arg[0]) {
+					case 'b': case 'B':
+						Ctrl->A.mode = TRIANGULATE2_READ_BULK; break;
+					case 'm': case 'M':
+						Ctrl->A.mode = TRIANGULATE2_READ_MMAP; break;
+					case 'r': case 'R':
+						Ctrl->A.mode = TRIANGULATE2_READ_RECORD; break;
+					case '\0':
+						Ctrl->A.mode = TRIANGULATE2_READ_AUTO; break;
+					default:
+						GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -A option: Give -Ab, -Am or -Ar\n");
+						n_errors++; break;
+				}
+				if (c) c[0] = '+';	/* Restore modifier */
+				break;
+			case 'C':
+				Ctrl->C.active = true;
+				if (!strcmp (opt->arg, "+s"))	/* Serve queries from standard input */
+					Ctrl->C.serve = true;
+				else if (!strncmp (opt->arg, "+u", 2U) && opt->arg[2]) {	/* Serve queries on a Unix socket */
+#ifdef WIN32
+					GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -C option: +u<socket> is not available under Windows\n");
+					n_errors++;
+#else
+					Ctrl->C.serve = true;
+					Ctrl->C.socket = strdup (&opt->arg[2]);
+#endif
+				}
+				else if (opt->arg[0] && gmt_check_filearg (GMT, 'C', opt->arg, GMT_IN, GMT_IS_DATASET))
+					Ctrl->C.file = strdup (opt->arg);
+				else {
+					GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -C option: Must specify a query file name, +s or +u<socket>\n");
+					n_errors++;
+				}
+				break;
 			case 'D':
 				Ctrl->D.active = true;
 				switch (opt->arg[0]) {
@@ -190,10 +3127,48 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 				Ctrl->E.value = (opt->arg[0] == 'N' || opt->arg[0] == 'n') ? GMT->session.d_NaN : atof (opt->arg);
 				break;
 			case 'G':
-				if ((Ctrl->G.active = gmt_check_filearg (GMT, 'G', opt->arg, GMT_OUT, GMT_IS_GRID)) != 0)
-					Ctrl->G.file = strdup (opt->arg);
-				else
-					n_errors++;
+				Ctrl->G.active = true;
+				if ((c = next_modifier (opt->arg, "xyzut")) != NULL) {	/* More grids from the same pass, or tiling */
+					char *m = NULL, *next = NULL;
+					unsigned int kind;
+					for (m = c; m; m = next) {
+						if ((next = next_modifier (&m[2], "xyzut")) != NULL) next[0] = '\0';
+						if (m[1] == 't') {	/* Rows per tile */
+							double rows;
+							if (!get_number (&m[2], &rows) || rows < 1.0 || rows > UINT_MAX || rows != floor (rows)) {
+								GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -G option: +t requires a positive number of rows\n");
+								n_errors++;
+							}
+							else
+								Ctrl->G.tile = (unsigned int)rows;
+							if (next) next[0] = '+';
+							continue;
+						}
+						switch (m[1]) {
+							case 'x': kind = TRIANGULATE2_DZDX; break;
+							case 'y': kind = TRIANGULATE2_DZDY; break;
+							case 'z': kind = TRIANGULATE2_Z; break;
+							default:  kind = TRIANGULATE2_SIGMA; break;
+						}
+						if (Ctrl->G.product[kind]) {
+							GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -G option: Modifier +%c given more than once\n", m[1]);
+							n_errors++;
+						}
+						else if (gmt_check_filearg (GMT, 'G', &m[2], GMT_OUT, GMT_IS_GRID))
+							Ctrl->G.product[kind] = strdup (&m[2]);
+						else
+							n_errors++;
+						if (next) next[0] = '+';
+					}
+					c[0] = '\0';	/* Chop off modifiers */
+				}
+				if (opt->arg[0]) {
+					if (gmt_check_filearg (GMT, 'G', opt->arg, GMT_OUT, GMT_IS_GRID))
+						Ctrl->G.file = strdup (opt->arg);
+					else
+						n_errors++;
+				}
+				if (c) c[0] = '+';	/* Restore modifiers */
 				break;
 			case 'I':
 				Ctrl->I.active = true;
@@ -202,6 +3177,34 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 					n_errors++;
 				}
 				break;
+			case 'L':
+				Ctrl->L.active = true;
+				if ((c = strstr (opt->arg, "+w")) != NULL) {
+					Ctrl->L.write = true;
+					c[0] = '\0';	/* Chop off modifier */
+				}
+				if (opt->arg[0])
+					Ctrl->L.file = strdup (opt->arg);
+				else {
+					GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -L option: Must specify a TIN file name\n");
+					n_errors++;
+				}
+				if (c) c[0] = '+';	/* Restore modifier */
+				break;
+			case 'W':
+				Ctrl->W.active = true;
+				if ((c = strstr (opt->arg, "+w")) != NULL) {
+					Ctrl->W.write = true;
+					c[0] = '\0';	/* Chop off modifier */
+				}
+				if (opt->arg[0])
+					Ctrl->W.file = strdup (opt->arg);
+				else {
+					GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -W option: Must specify a weight file name\n");
+					n_errors++;
+				}
+				if (c) c[0] = '+';	/* Restore modifier */
+				break;
 			case 'm':
 				if (gmt_M_compat_check (GMT, 4)) /* Warn and fall through */
 					GMT_Report (API, GMT_MSG_COMPAT, "Warning: -m option is deprecated and reverted back to -M.\n");
@@ -214,6 +3217,7 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 				break;
 			case 'N':
 				Ctrl->N.active = true;
+				if (strstr (opt->arg, "+n")) Ctrl->N.neighbors = true;
 				break;
 			case 'Q':
 				Ctrl->Q.active = true;
@@ -221,18 +3225,63 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 			case 'S':
 				Ctrl->S.active = true;
 				break;
+			case 'T':
+				Ctrl->T.active = true;
+				switch (opt->arg[0]) {
+					case 'g': case 'G':
+						Ctrl->T.mode = TRIANGULATE2_ENGINE_GMT; break;
+					case 'i': case 'I':
+						Ctrl->T.mode = TRIANGULATE2_ENGINE_BUILTIN; break;
+					case 'p': case 'P':
+						Ctrl->T.mode = TRIANGULATE2_ENGINE_PARALLEL; break;
+					default:
+						GMT_Report (API, GMT_MSG_NORMAL, "Syntax error: Give -Tg, -Ti or -Tp\n");
+						n_errors++; break;
+				}
+				break;
 			//CURVE
 				break;
 			case 'u':
+				if ((c = next_modifier (opt->arg, "adh")) != NULL) {	/* Model parameters; +s<scale> is left to the grid name */
+					char *m = NULL, *next = NULL;
+					double value;
+					for (m = c; m; m = next) {
+						if ((next = next_modifier (&m[2], "adh")) != NULL) next[0] = '\0';
+						if (!get_number (&m[2], &value)) {
+							GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -u option: +%c needs a number, not %s\n", m[1], &m[2]);
+							n_errors++;
+						}
+						else if (m[1] == 'a')
+							Ctrl->u.alpha = value;
+						else if (m[1] == 'h')
+							Ctrl->u.s_H = value;
+						else if ((Ctrl->u.delta_min = value) <= 0.0) {	/* Only leaving +d out gives the x increment */
+							GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -u option: +d<delta_min> must be positive\n");
+							n_errors++;
+						}
+						if (next) next[0] = '+';
+					}
+					c[0] = '\0';	/* Chop off modifiers */
+				}
 				if ((Ctrl->u.active = gmt_check_filearg (GMT, 'u', opt->arg, GMT_IN, GMT_IS_GRID)) != 0){
 					Ctrl->u.file = strdup (opt->arg);
 					GMT_Report (API, GMT_MSG_NORMAL, "filename %s\n", Ctrl->u.file);
 				}
 				else
 					n_errors++;
+				if (c) c[0] = '+';	/* Restore modifiers */
 				break;
 			case 'Z':
 				Ctrl->Z.active = true;
+				if (opt->arg[0]) {
+					uint64_t n_z;
+					if (get_count (opt->arg, TRIANGULATE2_MAX_Z, &n_z))
+						Ctrl->Z.n_z = (unsigned int)n_z;
+					else {
+						GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -Z option: Number of z columns must be 1-%d\n", TRIANGULATE2_MAX_Z);
+						n_errors++;
+					}
+				}
 				break;
 
 			default:	/* Report bad options */
@@ -241,50 +3290,86 @@ GMT_LOCAL int parse (struct GMT_CTRL *GMT, struct TRIANGULATE2_CTRL *Ctrl, struc
 		}
 	}
 
+	if (Ctrl->G.file) {	/* The main grid holds z, a slope (-D) or the uncertainty (-u) */
+		unsigned int kind = (Ctrl->D.dir == GMT_X) ? TRIANGULATE2_DZDX : ((Ctrl->D.dir == GMT_Y) ? TRIANGULATE2_DZDY : ((Ctrl->u.active) ? TRIANGULATE2_SIGMA : TRIANGULATE2_Z));
+		if (Ctrl->G.product[kind]) {
+			GMT_Report (API, GMT_MSG_NORMAL, "Syntax error -G option: %s is the same kind of grid as %s\n", Ctrl->G.product[kind], Ctrl->G.file);
+			n_errors++;
+		}
+		else
+			Ctrl->G.product[kind] = strdup (Ctrl->G.file);
+	}
+
 	gmt_check_lattice (GMT, Ctrl->I.inc, &GMT->common.r.registration, &Ctrl->I.active);
 
 	n_errors += gmt_check_binary_io (GMT, 2);
 	n_errors += gmt_M_check_condition (GMT, Ctrl->I.active && (Ctrl->I.inc[GMT_X] <= 0.0 || Ctrl->I.inc[GMT_Y] <= 0.0), "Syntax error -I option: Must specify positive increment(s)\n");
-	n_errors += gmt_M_check_condition (GMT, Ctrl->G.active && !Ctrl->G.file, "Syntax error -G option: Must specify file name\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->G.active && !(Ctrl->G.product[TRIANGULATE2_Z] || Ctrl->G.product[TRIANGULATE2_DZDX] || Ctrl->G.product[TRIANGULATE2_DZDY] || Ctrl->G.product[TRIANGULATE2_SIGMA]), "Syntax error -G option: Must specify file name\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->G.product[TRIANGULATE2_SIGMA] && !Ctrl->u.active, "Syntax error -G option: +u requires -u\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->u.active && (Ctrl->u.alpha <= 0.0 || Ctrl->u.s_H < 0.0), "Syntax error -u option: Need +a<alpha> > 0 and +h<s_H> >= 0\n");
 	n_errors += gmt_M_check_condition (GMT, Ctrl->G.active && (Ctrl->I.active + GMT->common.R.active) != 2, "Syntax error: Must specify -R, -I, -G for gridding\n");
 	(void)gmt_M_check_condition (GMT, !Ctrl->G.active && Ctrl->I.active, "Warning: -I not needed when -G is not set\n");
 	(void)gmt_M_check_condition (GMT, !(Ctrl->G.active || Ctrl->Q.active) && GMT->common.R.active, "Warning: -R not needed when -G or -Q are not set\n");
 	n_errors += gmt_M_check_condition (GMT, Ctrl->G.active && Ctrl->Q.active, "Syntax error -G option: Cannot be used with -Q\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->C.active && (Ctrl->G.active || Ctrl->M.active || Ctrl->N.active || Ctrl->Q.active || Ctrl->S.active), "Syntax error -C option: Cannot be used with -G, -M, -N, -Q, -S\n");
+	(void)gmt_M_check_condition (GMT, Ctrl->A.n_rows && (Ctrl->A.mode == TRIANGULATE2_READ_BULK || Ctrl->A.mode == TRIANGULATE2_READ_MMAP), "Warning -A option: +n is ignored with -Ab and -Am\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->C.serve && !Ctrl->C.socket && n_files == 0, "Syntax error -C option: With +s the data must come from a file since queries come from standard input\n");
 	n_errors += gmt_M_check_condition (GMT, Ctrl->S.active && Ctrl->Q.active, "Syntax error -S option: Cannot be used with -Q\n");
-	n_errors += gmt_M_check_condition (GMT, Ctrl->N.active && !Ctrl->G.active, "Syntax error -N option: Only required with -G\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->L.active && Ctrl->Q.active, "Syntax error -L option: Cannot be used with -Q\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->Z.n_z < 1 || Ctrl->Z.n_z > TRIANGULATE2_MAX_Z, "Syntax error -Z option: Number of z columns must be 1-%d\n", TRIANGULATE2_MAX_Z);
+	if (Ctrl->Z.n_z > 1) {	/* Each grid of z or its slopes needs a name per z column */
+		unsigned int kind;
+		for (kind = TRIANGULATE2_Z; kind <= TRIANGULATE2_DZDY; kind++)
+			n_errors += gmt_M_check_condition (GMT, Ctrl->G.product[kind] && !is_template (Ctrl->G.product[kind]), "Syntax error -G option: With -Z%u, %s must be a template with one %%d such as grid_%%03d.nc\n", Ctrl->Z.n_z, Ctrl->G.product[kind]);
+	}
+	n_errors += gmt_M_check_condition (GMT, Ctrl->W.active && !Ctrl->G.active, "Syntax error -W option: Requires -G\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->W.active && !Ctrl->W.write && Ctrl->L.active && !Ctrl->L.write, "Syntax error -W option: Cannot read both a weight file and a TIN file (-L)\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->W.active && !Ctrl->W.write && Ctrl->G.tile, "Syntax error -W option: Cannot be used with -G+t\n");
+	n_errors += gmt_M_check_condition (GMT, Ctrl->N.active && !Ctrl->N.neighbors && !Ctrl->G.active, "Syntax error -N option: Only required with -G\n");
 	n_errors += gmt_M_check_condition (GMT, Ctrl->Q.active && !GMT->common.R.active, "Syntax error -Q option: Requires -R\n");
+	(void)gmt_M_check_condition (GMT, Ctrl->Q.active && Ctrl->T.mode != TRIANGULATE2_ENGINE_GMT, "Warning: -Ti|p ignored since -Q uses the GMT library\n");
 	n_errors += gmt_M_check_condition (GMT, Ctrl->Q.active && GMT->current.setting.triangulate == GMT_TRIANGLE_WATSON, "Syntax error -Q option: Requires Shewchuk triangulation algorithm\n");
-	if (!(Ctrl->M.active || Ctrl->Q.active || Ctrl->S.active || Ctrl->N.active)) Ctrl->N.active = !Ctrl->G.active;	/* The default action */
+	if (!(Ctrl->M.active || Ctrl->Q.active || Ctrl->S.active || Ctrl->N.active || Ctrl->C.active)) Ctrl->N.active = !Ctrl->G.active;	/* The default action */
 
 	return (n_errors ? GMT_PARSE_ERROR : GMT_NOERROR);
 }
 
+GMT_LOCAL char *grid_file (struct TRIANGULATE2_CTRL *Ctrl, unsigned int kind, unsigned int b, char *file) {
+	/* Name of the output grid of this kind for z column b.  With several z columns the -G name is
+	 * a template for the z and slope grids; there is only one uncertainty grid. */
+	if (Ctrl->Z.n_z == 1 || kind == TRIANGULATE2_SIGMA) return (Ctrl->G.product[kind]);
+	snprintf (file, GMT_BUFSIZ, Ctrl->G.product[kind], b);
+	return (file);
+}
+
 #define bailout(code) {gmt_M_free_options (mode); return (code);}
 #define Return(code) {Free_Ctrl (GMT, Ctrl); gmt_end_module (GMT, GMT_cpy); bailout (code);}
+/* Once the input structures are initialized, release the points, triangles and weights on the way out */
+#define Free_Return(code) {free_input (GMT, &In); free_link (GMT, &Tin, &Weights, &link, &neighbor); gmt_M_free (GMT, weight); gmt_M_free (GMT, xe); gmt_M_free (GMT, ye); Return (code);}
 
 int GMT_triangulate2 (void *V_API, int mode, void *args) {
-	int *link = NULL;	/* Must remain int and not int due to triangle function */
+	uint64_t *link = NULL;	/* Vertex indices of the triangles, three per triangle */
+	uint64_t *neighbor = NULL;	/* Triangles across their three edges (see neighbor_table) */
+	uint64_t *curve = NULL;		/* Curve order in which to triangulate memory-mapped points (-Am -A+s) */
 	
-	uint64_t ij, ij1, ij2, ij3, np, i, j, k, n_edge, p, n = 0;
+	uint64_t ij, np, i, j, k, n_edge, p, inc, n = 0;
 	unsigned int n_input, n_output;
-	int row, col, col_min, col_max, row_min, row_max, error = 0;
+	int col, error = 0;
 	bool triplets[2] = {false, false}, map_them = false;
-	bool quadruplets[2] = {false, false}; //CURVE
-	bool quintuplets[2] = {false, false}; //CURVE
-	size_t n_alloc;
 	
-	double hj, hk, hl, vj, vk, vl, d,uv1,uv2,uv3,dv1,dv2,dv3,distv1,distv2,distv3;
-	double zj, zk, zl, zlj, zkj, xp, yp, a, b, c, f;
-	double xkj, xlj, ykj, ylj,out[3], vx[4], vy[4], out2[5];
-	double *xx = NULL, *yy = NULL, *zz = NULL, *in = NULL; double *uu = NULL, *hh = NULL, *vv = NULL; //CURVE
+	double out[6];
+	double *xx = NULL, *yy = NULL, *zz = NULL, *hh = NULL, *vv = NULL; //CURVE
 	double *xe = NULL, *ye = NULL;
 
 	char *tri_algorithm[2] = {"Watson", "Shewchuk"};
-	char record[GMT_BUFSIZ];
+	char record[GMT_BUFSIZ], file[GMT_BUFSIZ];
 
-	struct GMT_GRID *Grid = NULL;
+	struct GMT_GRID *Grid = NULL, *Product[TRIANGULATE2_N_PRODUCTS * TRIANGULATE2_MAX_Z];
 
-	struct TRIANGULATE2_EDGE *edge = NULL;
+	struct TRIANGULATE2_INPUT In;
+	struct TRIANGULATE2_TIN Tin;
+	struct TRIANGULATE2_WEIGHTS Weights;
+	struct TRIANGULATE2_WEIGHT *weight = NULL;
 	struct TRIANGULATE2_CTRL *Ctrl = NULL;
 	struct GMT_CTRL *GMT = NULL, *GMT_cpy = NULL;
 	struct GMT_OPTION *options = NULL;
@@ -308,168 +3393,143 @@ int GMT_triangulate2 (void *V_API, int mode, void *args) {
 
 	/*---------------------------- This is the triangulate2 main code ----------------------------*/
 
+	gmt_M_memset (&In, 1, struct TRIANGULATE2_INPUT);
+	gmt_M_memset (&Tin, 1, struct TRIANGULATE2_TIN);
+	gmt_M_memset (&Weights, 1, struct TRIANGULATE2_WEIGHTS);
+	gmt_M_memset (Product, TRIANGULATE2_N_PRODUCTS * TRIANGULATE2_MAX_Z, struct GMT_GRID *);
+	In.inc = 1;
+
 	GMT_Report (API, GMT_MSG_VERBOSE, "Processing input table data\n");
-	GMT_Report (API, GMT_MSG_LONG_VERBOSE, "%s triangulation algorithm selected\n", tri_algorithm[GMT->current.setting.triangulate]);
+	if (Ctrl->T.mode != TRIANGULATE2_ENGINE_GMT && !Ctrl->Q.active)
+		GMT_Report (API, GMT_MSG_LONG_VERBOSE, "Built-in %s triangulation selected\n", (Ctrl->T.mode == TRIANGULATE2_ENGINE_PARALLEL) ? "parallel" : "incremental");
+	else
+		GMT_Report (API, GMT_MSG_LONG_VERBOSE, "%s triangulation algorithm selected\n", tri_algorithm[GMT->current.setting.triangulate]);
 	
 	if (Ctrl->G.active) {
-		if ((Grid = GMT_Create_Data (API, GMT_IS_GRID, GMT_IS_SURFACE, GMT_GRID_HEADER_ONLY, NULL, NULL, Ctrl->I.inc, \
-			GMT_GRID_DEFAULT_REG, GMT_NOTSET, NULL)) == NULL) Return (API->error);
+		unsigned int kind, b;
+		for (kind = 0; kind < TRIANGULATE2_N_PRODUCTS; kind++) {
+			if (!Ctrl->G.product[kind]) continue;
+			for (b = 0; b < ((kind == TRIANGULATE2_SIGMA) ? 1 : Ctrl->Z.n_z); b++) {	/* One per z column, but a single uncertainty grid */
+				if ((Product[TRIANGULATE2_GRID (kind, b, Ctrl->Z.n_z)] = GMT_Create_Data (API, GMT_IS_GRID, GMT_IS_SURFACE, GMT_GRID_HEADER_ONLY, NULL, NULL, Ctrl->I.inc, \
+					GMT_GRID_DEFAULT_REG, GMT_NOTSET, NULL)) == NULL) Free_Return (API->error);
+				if (!Grid) Grid = Product[TRIANGULATE2_GRID (kind, b, Ctrl->Z.n_z)];	/* Supplies the region and dimensions */
+			}
+		}
 	}
 	if (Ctrl->Q.active && Ctrl->Z.active) GMT_Report (API, GMT_MSG_LONG_VERBOSE, "Warning: We will read (x,y,z), but only (x,y) will be output when -Q is used\n");
-	n_output = (Ctrl->N.active) ? 3 : 2;
+	n_output = (Ctrl->N.active) ? ((Ctrl->N.neighbors) ? 6 : 3) : 2;
 	if (Ctrl->M.active && Ctrl->Z.active) n_output = 3;
 	triplets[GMT_OUT] = (n_output == 3);
-	quadruplets[GMT_OUT] = (n_output == 4); //CURVE
-	quintuplets[GMT_OUT] = (n_output == 5); //CURVE
-	if ((error = gmt_set_cols (GMT, GMT_OUT, n_output)) != 0) Return (error);
+	if ((error = gmt_set_cols (GMT, GMT_OUT, n_output)) != 0) Free_Return (error);
 	
 	if (GMT->common.R.active && GMT->common.J.active) { /* Gave -R -J */
 		map_them = true;
-		if (gmt_M_err_pass (GMT, gmt_map_setup (GMT, Grid->header->wesn), "")) Return (GMT_PROJECTION_ERROR);
+		if (gmt_M_err_pass (GMT, gmt_map_setup (GMT, Grid->header->wesn), "")) Free_Return (GMT_PROJECTION_ERROR);
 	}
 
 	/* Now we are ready to take on some input values */
 
-	n_input = (Ctrl->G.active || Ctrl->Z.active) ? 3 : 2;
+	In.n_z = (Ctrl->G.active || Ctrl->Z.active || Ctrl->C.active) ? Ctrl->Z.n_z : 0;
+	n_input = 2 + In.n_z;
 	n_input = (Ctrl->u.active) ? n_input + 2 : n_input;//CURVE
 	if ((error = gmt_set_cols (GMT, GMT_IN, n_input)) != GMT_NOERROR) {
-		Return (error);
+		Free_Return (error);
 	}
 
-	/* Initialize the i/o since we are doing record-by-record reading/writing */
-	if (GMT_Init_IO (API, GMT_IS_DATASET, GMT_IS_POINT, GMT_IN, GMT_ADD_DEFAULT, 0, options) != GMT_NOERROR) {	/* Establishes data input */
-		Return (API->error);
-	}
-	if (GMT_Begin_IO (API, GMT_IS_DATASET, GMT_IN, GMT_HEADER_ON) != GMT_NOERROR) {	/* Enables data input and sets access mode */
-		Return (API->error);
-	}
-
-	triplets[GMT_IN] = (n_input == 3); //GMT_OUT=0, GMT_IN=1
-	//CURVE
-	quadruplets[GMT_IN] = (n_input == 4);
-	quintuplets[GMT_IN] = (n_input == 5);
-	n_alloc = GMT_INITIAL_MEM_ROW_ALLOC;
-	xx = gmt_M_memory (GMT, NULL, n_alloc, double);
-	yy = gmt_M_memory (GMT, NULL, n_alloc, double);
-	if (triplets[GMT_IN]) zz = gmt_M_memory (GMT, NULL, n_alloc, double);
-	//CURVE
-	if (quadruplets[GMT_IN]){
-		hh = gmt_M_memory (GMT, NULL, n_alloc, double);
-		vv = gmt_M_memory (GMT, NULL, n_alloc, double);
-	}
-	if (quintuplets[GMT_IN])
-	{
-		zz = gmt_M_memory (GMT, NULL, n_alloc, double);
-		hh = gmt_M_memory (GMT, NULL, n_alloc, double);
-		vv = gmt_M_memory (GMT, NULL, n_alloc, double);
-	}
-	n = 0;
-	do {	/* Keep returning records until we reach EOF */
-		if ((in = GMT_Get_Record (API, GMT_READ_DOUBLE, NULL)) == NULL) {	/* Read next record, get NULL if special case */
-			if (gmt_M_rec_is_error (GMT)) {		/* Bail if there are any read errors */
-				gmt_M_free (GMT, xx);		gmt_M_free (GMT, yy);		gmt_M_free (GMT, zz); gmt_M_free (GMT, hh); gmt_M_free (GMT, vv);//CURVE
-				Return (GMT_RUNTIME_ERROR);
-			}
-			if (gmt_M_rec_is_any_header (GMT)) 	/* Skip all headers */
-				continue;
-			if (gmt_M_rec_is_eof (GMT)) 		/* Reached end of file */
-				break;
+	if (Ctrl->A.mode == TRIANGULATE2_READ_MMAP && (error = map_binary (GMT, options, n_input, &In)) != GMT_NOERROR)
+		Free_Return (error);
+	if (!In.map && !(Ctrl->A.mode == TRIANGULATE2_READ_AUTO && parse_ascii (GMT, options, n_input, &In))) {	/* Initialize the i/o for reading the input table */
+		if (GMT_Init_IO (API, GMT_IS_DATASET, GMT_IS_POINT, GMT_IN, GMT_ADD_DEFAULT, 0, options) != GMT_NOERROR) {	/* Establishes data input */
+			Free_Return (API->error);
 		}
+		if (Ctrl->A.mode == TRIANGULATE2_READ_BULK)
+			error = read_dataset (GMT, n_input, &In);
+		else
+			error = read_records (GMT, options, n_input, Ctrl->A.n_rows, &In);
+		if (error) Free_Return (error);
+	}
 
-		/* Data record to process */
-	
-		xx[n] = in[GMT_X];	yy[n] = in[GMT_Y];
-		if (triplets[GMT_IN]) zz[n] = in[GMT_Z];
-		//CURVE
-		if (quadruplets[GMT_IN]){
-			hh[n] = fabs(in[GMT_H]);
-			vv[n] = fabs(in[GMT_V]);
-		}
-		if (quintuplets[GMT_IN])
-		{
-			zz[n] = in[GMT_Z]; 
-			hh[n] = fabs(in[GMT_H]);
-			vv[n] = fabs(in[GMT_V]);
-		}
-		n++;
+	n = In.n;	inc = In.inc;
+	xx = In.col[GMT_X];	yy = In.col[GMT_Y];	zz = In.col[GMT_Z];
+	hh = In.col[GMT_H];	vv = In.col[GMT_V];	//CURVE
 
-		if (n == n_alloc) {	/* Get more memory */
-			n_alloc <<= 1;
-			xx = gmt_M_memory (GMT, xx, n_alloc, double);
-			yy = gmt_M_memory (GMT, yy, n_alloc, double);
-			if (triplets[GMT_IN]) zz = gmt_M_memory (GMT, zz, n_alloc, double);
-			//CURVE
-			if (quadruplets[GMT_IN]){
-				hh = gmt_M_memory (GMT, hh, n_alloc, double); 
-				vv = gmt_M_memory (GMT, vv, n_alloc, double);
-			}
-			if (quintuplets[GMT_IN])
-			{
-				zz = gmt_M_memory (GMT, zz, n_alloc, double);
-				hh = gmt_M_memory (GMT, hh, n_alloc, double); 
-				vv = gmt_M_memory (GMT, vv, n_alloc, double);
-			}
+	if (n == 0) {
+		GMT_Report (API, GMT_MSG_NORMAL, "Error: No data points given - so no triangulation can take effect\n");
+		Free_Return (GMT_RUNTIME_ERROR);
+	}
+	if (Ctrl->L.active && !Ctrl->L.write) {	/* Reuse a saved triangulation */
+		if ((error = read_tin (GMT, Ctrl->L.file, xx, yy, inc, n, &Tin)) != GMT_NOERROR) {
+			Free_Return (error);
 		}
-		if (n == INT_MAX) {
-			GMT_Report (API, GMT_MSG_NORMAL, "Error: Cannot triangulate2 more than %d points\n", INT_MAX);
-			gmt_M_free (GMT, xx);
-			gmt_M_free (GMT, yy);
-			if (triplets[GMT_IN]) gmt_M_free (GMT, zz);
-			//CURVE
-			if (quadruplets[GMT_IN]){
-				gmt_M_free (GMT, hh);
-				gmt_M_free (GMT, vv);
-			}
-			if (quintuplets[GMT_IN])
-			{
-				gmt_M_free (GMT, zz);
-				gmt_M_free (GMT, hh);
-				gmt_M_free (GMT, vv);
-			}
-			Return (GMT_RUNTIME_ERROR);
+		if (Ctrl->A.sort) GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: +s is ignored when the triangulation is read with -L\n");
+	}
+	else if (Ctrl->W.active && !Ctrl->W.write) {	/* Reuse saved triangles and node weights */
+		if ((error = read_weights (GMT, Ctrl->W.file, xx, yy, inc, n, Grid->header, &Weights)) != GMT_NOERROR) {
+			Free_Return (error);
 		}
-	} while (true);
-	
-	if (GMT_End_IO (API, GMT_IN, 0) != GMT_NOERROR) {	/* Disables further data input */
-		Return (API->error);
+		if (Ctrl->A.sort) GMT_Report (API, GMT_MSG_VERBOSE, "Warning -A option: +s is ignored when the weights are read with -W\n");
 	}
-
-	xx = gmt_M_memory (GMT, xx, n, double);
-	yy = gmt_M_memory (GMT, yy, n, double);
-	if (triplets[GMT_IN]) zz = gmt_M_memory (GMT, zz, n, double);
-	//CURVE
-	if (quadruplets[GMT_IN]){
-		hh = gmt_M_memory (GMT, hh, n, double);
-		vv = gmt_M_memory (GMT, vv, n, double);
+	else if (n > INT_MAX && (Ctrl->Q.active || Ctrl->T.mode == TRIANGULATE2_ENGINE_GMT)) {	/* gmt_delaunay and gmt_voronoi index the points with int */
+		GMT_Report (API, GMT_MSG_NORMAL, "Error: The %s triangulation cannot handle more than %d points\n", tri_algorithm[GMT->current.setting.triangulate], INT_MAX);
+		Free_Return (GMT_RUNTIME_ERROR);
 	}
-	if (quintuplets[GMT_IN])
-	{
-		zz = gmt_M_memory (GMT, zz, n, double);
-		hh = gmt_M_memory (GMT, hh, n, double);
-		vv = gmt_M_memory (GMT, vv, n, double);
+	else if (Ctrl->A.sort && !Ctrl->Q.active && In.map) {	/* Keep the mapping; only the copy of x,y we triangulate is reordered */
+		GMT_Report (API, GMT_MSG_VERBOSE, "Triangulate points in %s curve order\n", (Ctrl->A.sort == TRIANGULATE2_SORT_MORTON) ? "Morton" : "Hilbert");
+		curve = curve_order (GMT, xx, yy, n, inc, Ctrl->A.sort);
 	}
-
-	if (n == 0) {
-		GMT_Report (API, GMT_MSG_NORMAL, "Error: No data points given - so no triangulation can take effect\n");
-		Return (GMT_RUNTIME_ERROR);
+	else if (Ctrl->A.sort && !Ctrl->Q.active) {	/* Order points along a space-filling curve */
+		GMT_Report (API, GMT_MSG_VERBOSE, "Reorder points along a %s curve\n", (Ctrl->A.sort == TRIANGULATE2_SORT_MORTON) ? "Morton" : "Hilbert");
+		sort_points (GMT, &In, Ctrl->A.sort);
+		xx = In.col[GMT_X];	yy = In.col[GMT_Y];	zz = In.col[GMT_Z];
+		hh = In.col[GMT_H];	vv = In.col[GMT_V];	//CURVE
+		inc = In.inc;
 	}
 
-	if (map_them) {	/* Must make parallel arrays for projected x/y */
+	if (Tin.link) {	/* Already triangulated */
+		link = Tin.link;
+		np = Tin.H->n_triangles;
+	}
+	else if (Weights.link) {	/* Likewise */
+		link = Weights.link;
+		np = Weights.H->n_triangles;
+	}
+	else if (map_them || inc > 1) {	/* Must make parallel contiguous arrays for projected or strided x/y */
 		double *xxp = NULL, *yyp = NULL;
 
 		xxp = gmt_M_memory (GMT, NULL, n, double);
 		yyp = gmt_M_memory (GMT, NULL, n, double);
-		for (i = 0; i < n; i++) gmt_geo_to_xy (GMT, xx[i], yy[i], &xxp[i], &yyp[i]);
-
-		GMT_Report (API, GMT_MSG_VERBOSE, "Do Delaunay optimal triangulation on projected coordinates\n");
+		if (map_them) {
+			for (i = 0; i < n; i++) {
+				j = (curve) ? curve[i] : i;
+				gmt_geo_to_xy (GMT, xx[j*inc], yy[j*inc], &xxp[i], &yyp[i]);
+			}
+			GMT_Report (API, GMT_MSG_VERBOSE, "Do Delaunay optimal triangulation on projected coordinates\n");
+		}
+		else if (curve) {
+			for (i = 0; i < n; i++) xxp[i] = xx[curve[i]*inc], yyp[i] = yy[curve[i]*inc];
+			GMT_Report (API, GMT_MSG_VERBOSE, "Do Delaunay optimal triangulation on given coordinates\n");
+		}
+		else {
+			for (i = 0; i < n; i++) xxp[i] = xx[i*inc], yyp[i] = yy[i*inc];
+			GMT_Report (API, GMT_MSG_VERBOSE, "Do Delaunay optimal triangulation on given coordinates\n");
+		}
 
 		if (Ctrl->Q.active) {
 			double we[2];
-			we[0] = GMT->current.proj.rect[XLO];	we[1] = GMT->current.proj.rect[XHI];
+			if (map_them) {
+				we[0] = GMT->current.proj.rect[XLO];	we[1] = GMT->current.proj.rect[XHI];
+			}
+			else {
+				we[0] = GMT->common.R.wesn[XLO];	we[1] = GMT->common.R.wesn[XHI];
+			}
 			np = gmt_voronoi (GMT, xxp, yyp, n, we, &xe, &ye);
 		}
 		else
-			np = gmt_delaunay (GMT, xxp, yyp, n, &link);
+			np = delaunay (GMT, xxp, yyp, n, Ctrl->T.mode, &link);
+		if (curve) {	/* Back to the record numbers in the mapping */
+			for (k = 0; k < 3 * np; k++) link[k] = curve[link[k]];
+			gmt_M_free (GMT, curve);
+		}
 
 		gmt_M_free (GMT, xxp);
 		gmt_M_free (GMT, yyp);
@@ -483,137 +3543,179 @@ int GMT_triangulate2 (void *V_API, int mode, void *args) {
 			np = gmt_voronoi (GMT, xx, yy, n, we, &xe, &ye);
 		}
 		else
-			np = gmt_delaunay (GMT, xx, yy, n, &link);
+			np = delaunay (GMT, xx, yy, n, Ctrl->T.mode, &link);
 	}
 
 	if (Ctrl->Q.active)
 		GMT_Report (API, GMT_MSG_VERBOSE, "%" PRIu64 " Voronoi edges found\n", np);
 	else
 		GMT_Report (API, GMT_MSG_VERBOSE, "%" PRIu64 " Delaunay triangles found\n", np);
-	
+
+	if (!Ctrl->Q.active && ((Ctrl->G.active && !Weights.map) || Ctrl->M.active || Ctrl->N.neighbors || Ctrl->L.write || Ctrl->C.active))	/* Who is next to whom */
+		neighbor = (Tin.neighbor) ? Tin.neighbor : neighbor_table (GMT, link, np, n);
 
 	if (Ctrl->G.active) {	/* Grid via planar triangle segments */
 		int n_columns = Grid->header->n_columns, n_rows = Grid->header->n_rows;	/* Signed versions */
-		if (GMT_Create_Data (API, GMT_IS_GRID, GMT_IS_GRID, GMT_GRID_DATA_ONLY, NULL, NULL, NULL, 0, 0, Grid) == NULL) {
-			if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);	/* Coverity says it would leak */
-			Return (API->error);
-		}
+		unsigned int k, n_z = Ctrl->Z.n_z, n_grids = TRIANGULATE2_N_PRODUCTS * n_z, tile = MIN (Ctrl->G.tile, Grid->header->n_rows);
+		struct TRIANGULATE2_RASTER R;
 
+		gmt_M_memset (&R, 1, struct TRIANGULATE2_RASTER);
 		if (!Ctrl->E.active) Ctrl->E.value = GMT->session.d_NaN;
-		for (p = 0; p < Grid->header->size; p++)Grid->data[p] = (float)Ctrl->E.value;	/* initialize grid */
-
-		struct GMT_GRID *Slopes = NULL;
-		double *CoordsX = NULL, *CoordsY = NULL;
-		if ((Slopes = GMT_Read_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_ALL, NULL, Ctrl->u.file, NULL)) == NULL)
-			Return (API->error);
-
-		//This is the CURVE
-
-		double alpha = 2.0;
-		double delta_min = *Ctrl->I.inc;
-		double  s_H = 1.0, distSum = 0.0, sigma = 0.0;
-
-		if ((CoordsX = GMT_Get_Coord (API, GMT_IS_GRID, GMT_X, Grid)) == NULL)
-			Return (API->error);
-
-		if ((CoordsY = GMT_Get_Coord (API, GMT_IS_GRID, GMT_Y, Grid)) == NULL)
-			Return (API->error);
-
-		for (k = ij = 0; k < np; k++) {
-			/* Find equation for the plane as z = ax + by + c */
-
-			vx[0] = vx[3] = xx[link[ij]];	vy[0] = vy[3] = yy[link[ij]];	zj = zz[link[ij++]]; hj = hh[link[ij-1]]; vj = vv[link[ij-1]];
-			vx[1] = xx[link[ij]];			vy[1] = yy[link[ij]];	zk = zz[link[ij++]]; hk = hh[link[ij-1]]; vk = vv[link[ij-1]];
-			vx[2] = xx[link[ij]];			vy[2] = yy[link[ij]];	zl = zz[link[ij++]]; hl = hh[link[ij-1]]; vl = vv[link[ij-1]];
-
-			xkj = vx[1] - vx[0];	ykj = vy[1] - vy[0];	zkj = zk - zj;
-			xlj = vx[2] - vx[0];	ylj = vy[2] - vy[0];	zlj = zl - zj;
-
-			f = 1.0 / (xkj * ylj - ykj * xlj);
-			a = -f * (ykj * zlj - zkj * ylj);
-			b = -f * (zkj * xlj - xkj * zlj);
-			c = -a * vx[1] - b * vy[1] + zk;
-
-			/* Compute grid indices the current triangle may cover, assuming all triangles are
-			   in the -R region (Grid->header->wesn[XLO]/x_max etc.)  Always, col_min <= col_max, row_min <= row_max.
-			 */
-
-			xp = MIN (MIN (vx[0], vx[1]), vx[2]);	col_min = (int)gmt_M_grd_x_to_col (GMT, xp, Grid->header);
-			xp = MAX (MAX (vx[0], vx[1]), vx[2]);	col_max = (int)gmt_M_grd_x_to_col (GMT, xp, Grid->header);
-			yp = MAX (MAX (vy[0], vy[1]), vy[2]);	row_min = (int)gmt_M_grd_y_to_row (GMT, yp, Grid->header);
-			yp = MIN (MIN (vy[0], vy[1]), vy[2]);	row_max = (int)gmt_M_grd_y_to_row (GMT, yp, Grid->header);
-
-			/* Adjustments for triangles outside -R region. */
-			/* Triangle to the left or right. */
-			if ((col_max < 0) || (col_min >= n_columns)) continue;
-			/* Triangle Above or below */
-			if ((row_max < 0) || (row_min >= n_rows)) continue;
-
-			/* Triangle covers boundary, left or right. */
-			if (col_min < 0) col_min = 0;       if (col_max >= n_columns) col_max = Grid->header->n_columns - 1;
-			/* Triangle covers boundary, top or bottom. */
-			if (row_min < 0) row_min = 0;       if (row_max >= n_rows) row_max = Grid->header->n_rows - 1;
-
-			for (row = row_min; row <= row_max; row++) {
-				yp = gmt_M_grd_row_to_y (GMT, row, Grid->header);
-				p = gmt_M_ijp (Grid->header, row, col_min);
-				for (col = col_min; col <= col_max; col++, p++) {
-					xp = gmt_M_grd_col_to_x (GMT, col, Grid->header);
-
-					if (!gmt_non_zero_winding (GMT, xp, yp, vx, vy, 4)) continue;	/* Outside */
-
-					if (Ctrl->D.dir == GMT_X)
-						Grid->data[p] = (float)a;
-					else if (Ctrl->D.dir == GMT_Y)
-						Grid->data[p] = (float)b;
-					else
-					{
-						//=================================================================================
-						distv1 = sqrt(pow(CoordsX[col] - vx[0],2.0) + pow(CoordsY[row] - vy[0],2.0));
-						distv2 = sqrt(pow(CoordsX[col] - vx[1],2.0) + pow(CoordsY[row] - vy[1],2.0));
-						distv3 = sqrt(pow(CoordsX[col] - vx[2],2.0) + pow(CoordsY[row] - vy[2],2.0));
-						uv1 = pow(vj,2.0)*(1.0 + pow((distv1 + s_H*hj)/delta_min,alpha)) + pow(tan((double)Slopes->data[p])*hj,2.0);
-						uv2 = pow(vk,2.0)*(1.0 + pow((distv2 + s_H*hk)/delta_min,alpha)) + pow(tan((double)Slopes->data[p])*hk,2.0);
-						uv3 = pow(vl,2.0)*(1.0 + pow((distv3 + s_H*hl)/delta_min,alpha)) + pow(tan((double)Slopes->data[p])*hl,2.0);
-						if(abs(distv1) < EPS_D)
-							sigma = sqrt(uv1);
-						else if(abs(distv2) < EPS_D)
-							sigma = sqrt(uv2);
-						else if(abs(distv3) < EPS_D)
-							sigma = sqrt(uv3);
-						else
-						{
-							dv1 = uv1/distv1;
-							dv2 = uv2/distv2;
-							dv3 = uv3/distv3;
-							distSum = 1.0/distv1 + 1.0/distv2 + 1.0/distv3;
-							sigma = sqrt((dv1 + dv2 + dv3) / distSum);
-						}
-						//=================================================================================
-						Grid->data[p] = (!Ctrl->u.active) ? (float)(a * xp + b * yp + c) : (float)(sigma);
-					}
+		for (k = 0; k < n_grids; k++) {	/* Allocate and initialize the grids we are asked for */
+			if (!Product[k]) continue;
+			if (tile) {	/* Open the grid for writing a row at a time and only hold a tile of it */
+				if (GMT_Set_Comment (API, GMT_IS_GRID, GMT_COMMENT_IS_OPTION | GMT_COMMENT_IS_COMMAND, options, Product[k]) ||
+				    GMT_Write_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_HEADER_ONLY | GMT_GRID_ROW_BY_ROW, NULL, grid_file (Ctrl, k / n_z, k % n_z, file), Product[k]) != GMT_NOERROR) {
+					for (k = 0; k < n_grids; k++) if (Product[k]) gmt_M_free (GMT, Product[k]->data);	/* The tiles so far */
+					Free_Return (API->error);
+				}
+				Product[k]->data = gmt_M_memory (GMT, NULL, (tile + Grid->header->pad[YHI] + Grid->header->pad[YLO]) * Grid->header->mx, float);
+				continue;
+			}
+			if (GMT_Create_Data (API, GMT_IS_GRID, GMT_IS_GRID, GMT_GRID_DATA_ONLY, NULL, NULL, NULL, 0, 0, Product[k]) == NULL) {
+				Free_Return (API->error);
+			}
+			for (p = 0; p < Grid->header->size; p++) Product[k]->data[p] = (float)Ctrl->E.value;
+		}
+		R.link = link;	R.inc = inc;
+		if (!Weights.map) R.hull = hull_edges (GMT, neighbor, np);
+		R.x = xx;	R.y = yy;	R.h = hh;	R.v = vv;
+		R.n_z = n_z;
+		for (k = 0; k < n_z; k++) R.z[k] = In.col[TRIANGULATE2_ZCOL (k)];
+		R.header = Grid->header;
+		R.Product = Product;
+		R.xcol = gmt_M_memory (GMT, NULL, n_columns, double);
+		for (col = 0; col < n_columns; col++) R.xcol[col] = gmt_M_grd_col_to_x (GMT, col, Grid->header);
+		if (Product[TRIANGULATE2_GRID (TRIANGULATE2_SIGMA, 0, n_z)]) {	//CURVE
+			R.alpha = Ctrl->u.alpha;	R.s_H = Ctrl->u.s_H;
+			R.delta_min = (Ctrl->u.delta_min > 0.0) ? Ctrl->u.delta_min : Ctrl->I.inc[GMT_X];
+			R.sigma_span = select_sigma_span (GMT, R.alpha);
+			R.slope_file = Ctrl->u.file;
+		}
+		if (Ctrl->W.write) {	/* Record where each node falls as we grid */
+			uint64_t node, n_nodes = (uint64_t)n_columns * n_rows;
+			R.weight = weight = gmt_M_memory (GMT, NULL, n_nodes, struct TRIANGULATE2_WEIGHT);
+			for (node = 0; node < n_nodes; node++) weight[node].tri = UINT64_MAX;
+		}
+		if (Weights.map) {	/* Just gather from the saved weights */
+			if (!R.slope_file || (error = read_slopes (GMT, &R, 0, n_rows - 1)) == GMT_NOERROR)
+				apply_weights (GMT, &R, &Weights);
+		}
+		else if (tile) {	/* Grid and write the tiles one by one, then put the final range in the headers */
+			error = grid_tiles (GMT, &R, np, tile, (float)Ctrl->E.value);
+			for (k = 0; k < n_grids; k++) {
+				if (!Product[k]) continue;
+				gmt_M_free (GMT, Product[k]->data);
+				if (!error && gmt_update_grd_info (GMT, grid_file (Ctrl, k / n_z, k % n_z, file), Product[k]->header)) {
+					GMT_Report (API, GMT_MSG_NORMAL, "Error updating the header of %s\n", file);
+					error = GMT_GRID_WRITE_ERROR;
 				}
 			}
 		}
-		if (GMT_Set_Comment (API, GMT_IS_GRID, GMT_COMMENT_IS_OPTION | GMT_COMMENT_IS_COMMAND, options, Grid)) {
-			if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);	/* Coverity says it would leak */
-			Return (API->error);
+		else if (!R.slope_file || (error = read_slopes (GMT, &R, 0, n_rows - 1)) == GMT_NOERROR)	/* CURVE: Only the slopes inside -R */
+			grid_triangles (GMT, &R, NULL, np, 0, n_rows - 1);
+		gmt_M_free (GMT, R.xcol);
+		gmt_M_free (GMT, R.hull);
+		gmt_M_free (GMT, R.tan2_slope);
+		if (error) {
+			Free_Return (error);
 		}
-		if (GMT_Write_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_ALL, NULL, Ctrl->G.file, Grid) != GMT_NOERROR) {
-			if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);
-			Return (API->error);
+
+		for (k = 0; !tile && k < n_grids; k++) {
+			if (!Product[k]) continue;
+			if (GMT_Set_Comment (API, GMT_IS_GRID, GMT_COMMENT_IS_OPTION | GMT_COMMENT_IS_COMMAND, options, Product[k])) {
+				Free_Return (API->error);
+			}
+			if (GMT_Write_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_ALL, NULL, grid_file (Ctrl, k / n_z, k % n_z, file), Product[k]) != GMT_NOERROR) {
+				Free_Return (API->error);
+			}
 		}
 		GMT_Report (API, GMT_MSG_VERBOSE, "Done!\n");
 	}
-	
+
+	if (Ctrl->C.active) {	/* Interpolate at the query points */
+		unsigned int k, n_out = 2 + Ctrl->Z.n_z + Ctrl->u.active;
+		uint64_t last = 0;
+		struct TRIANGULATE2_RASTER R;
+		struct GMT_DATASET *D = NULL;
+
+		gmt_M_memset (&R, 1, struct TRIANGULATE2_RASTER);
+		R.link = link;	R.neighbor = neighbor;	R.np = np;	R.inc = inc;
+		R.x = xx;	R.y = yy;	R.h = hh;	R.v = vv;
+		R.n_z = Ctrl->Z.n_z;
+		for (k = 0; k < R.n_z; k++) R.z[k] = In.col[TRIANGULATE2_ZCOL (k)];
+		jump_grid (GMT, &R);
+		if (Ctrl->u.active) {	//CURVE: Slopes at the query points come from the whole grid
+			if ((R.Slopes = GMT_Read_Data (API, GMT_IS_GRID, GMT_IS_FILE, GMT_IS_SURFACE, GMT_GRID_ALL, NULL, Ctrl->u.file, NULL)) == NULL) {
+				gmt_M_free (GMT, R.jump);
+				Free_Return (API->error);
+			}
+			R.alpha = Ctrl->u.alpha;	R.s_H = Ctrl->u.s_H;
+			R.delta_min = (Ctrl->u.delta_min > 0.0) ? Ctrl->u.delta_min : R.Slopes->header->inc[GMT_X];
+			R.sigma_span = select_sigma_span (GMT, R.alpha);
+		}
+		if (!Ctrl->E.active) Ctrl->E.value = GMT->session.d_NaN;
+		if ((error = gmt_set_cols (GMT, GMT_IN, 2)) != GMT_NOERROR || (error = gmt_set_cols (GMT, GMT_OUT, n_out)) != GMT_NOERROR) {
+			if (R.Slopes) GMT_Destroy_Data (API, &R.Slopes);
+			gmt_M_free (GMT, R.jump);
+			Free_Return (error);
+		}
+		for (k = GMT_Z; k < n_out; k++) GMT->current.io.col_type[GMT_OUT][k] = GMT_IS_FLOAT;
+		if (Ctrl->C.serve) {	/* Keep the triangulation and answer queries as they come */
+#ifndef WIN32
+			if (Ctrl->C.socket)
+				error = serve_socket (GMT, &R, Ctrl->C.socket, &last, Ctrl->E.value);
+			else
+#endif
+			{
+				GMT_Report (API, GMT_MSG_VERBOSE, "Serve queries on standard input\n");
+				(void)serve_queries (GMT, &R, GMT->session.std[GMT_IN], GMT->session.std[GMT_OUT], &last, Ctrl->E.value);
+			}
+		}
+		else {	/* Answer the points in the query file */
+			if ((D = GMT_Read_Data (API, GMT_IS_DATASET, GMT_IS_FILE, GMT_IS_POINT, GMT_READ_NORMAL, NULL, Ctrl->C.file, NULL)) == NULL) {
+				if (R.Slopes) GMT_Destroy_Data (API, &R.Slopes);
+				gmt_M_free (GMT, R.jump);
+				Free_Return (API->error);
+			}
+			if (GMT_Init_IO (API, GMT_IS_DATASET, GMT_IS_POINT, GMT_OUT, GMT_ADD_DEFAULT, 0, options) != GMT_NOERROR ||
+			    GMT_Begin_IO (API, GMT_IS_DATASET, GMT_OUT, GMT_HEADER_ON) != GMT_NOERROR) {
+				GMT_Destroy_Data (API, &D);
+				if (R.Slopes) GMT_Destroy_Data (API, &R.Slopes);
+				gmt_M_free (GMT, R.jump);
+				Free_Return (API->error);
+			}
+			if (D->n_segments > 1) gmt_set_segmentheader (GMT, GMT_OUT, true);
+			GMT_Report (API, GMT_MSG_VERBOSE, "Interpolate at %" PRIu64 " query points\n", D->n_records);
+			error = write_answers (GMT, &R, D, &last, Ctrl->E.value);
+			if (GMT_End_IO (API, GMT_OUT, 0) != GMT_NOERROR) error = API->error;
+			GMT_Destroy_Data (API, &D);
+		}
+		if (R.Slopes) GMT_Destroy_Data (API, &R.Slopes);
+		gmt_M_free (GMT, R.jump);
+		if (error) {
+			Free_Return (error);
+		}
+	}
+
+	if (In.id && !Ctrl->Q.active) restore_order (GMT, &In, link, np);	/* Report input record numbers */
+	if (Ctrl->L.write && (error = write_tin (GMT, Ctrl->L.file, xx, yy, inc, n, link, neighbor, np)) != GMT_NOERROR) {
+		Free_Return (error);
+	}
+	if (weight) {	/* Save the node weights (-W+w) */
+		error = write_weights (GMT, Ctrl->W.file, xx, yy, inc, n, link, np, Grid->header, weight);
+		gmt_M_free (GMT, weight);
+		if (error) {
+			Free_Return (error);
+		}
+	}
+
 	if (Ctrl->M.active || Ctrl->Q.active || Ctrl->S.active || Ctrl->N.active) {	/* Requires output to stdout */
 		if (GMT_Init_IO (API, GMT_IS_DATASET, GMT_IS_POINT, GMT_OUT, GMT_ADD_DEFAULT, 0, options) != GMT_NOERROR) {	/* Establishes data output */
-			if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);	/* Coverity says it would leak */
-			Return (API->error);
+			Free_Return (API->error);
 		}
 		if (GMT_Begin_IO (API, GMT_IS_DATASET, GMT_OUT, GMT_HEADER_ON) != GMT_NOERROR) {	/* Enables data output and sets access mode */
-			if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);	/* Coverity says it would leak */
-			Return (API->error);
+			Free_Return (API->error);
 		}
 		if (Ctrl->M.active || Ctrl->Q.active) {	/* Must find unique edges to output only once */
 			gmt_set_segmentheader (GMT, GMT_OUT, true);
@@ -629,42 +3731,35 @@ int GMT_triangulate2 (void *V_API, int mode, void *args) {
 				gmt_M_free (GMT, xe);
 				gmt_M_free (GMT, ye);
 			}
-			else {	/* Triangle edges */
-				n_edge = 3 * np;
-				edge = gmt_M_memory (GMT, NULL, n_edge, struct TRIANGULATE2_EDGE);
-				for (i = ij1 = 0, ij2 = 1, ij3 = 2; i < np; i++, ij1 += 3, ij2 += 3, ij3 += 3) {
-					edge[ij1].begin = link[ij1];	edge[ij1].end = link[ij2];
-					edge[ij2].begin = link[ij2];	edge[ij2].end = link[ij3];
-					edge[ij3].begin = link[ij1];	edge[ij3].end = link[ij3];
-				}
-				for (i = 0; i < n_edge; i++) if (edge[i].begin > edge[i].end) int_swap (edge[i].begin, edge[i].end);
-
-				qsort (edge, n_edge, sizeof (struct TRIANGULATE2_EDGE), compare_edge);
-				for (i = 1, j = 0; i < n_edge; i++) {
-					if (edge[i].begin != edge[j].begin || edge[i].end != edge[j].end) j++;
-					edge[j] = edge[i];
-				}
-				n_edge = j + 1;
+			else {	/* Triangle edges, by lower then upper vertex */
+				uint64_t *start = NULL, *end = unique_edges (GMT, link, neighbor, np, n, &start);
 
+				n_edge = start[n];
 				GMT_Report (API, GMT_MSG_VERBOSE, "%" PRIu64 " unique triangle edges\n", n_edge);
-				for (i = 0; i < n_edge; i++) {
-					sprintf (record, "Edge %d-%d", edge[i].begin, edge[i].end);
-					GMT_Put_Record (API, GMT_WRITE_SEGMENT_HEADER, record);
-					out[GMT_X] = xx[edge[i].begin];	out[GMT_Y] = yy[edge[i].begin];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[edge[i].begin];
-					GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);
-					out[GMT_X] = xx[edge[i].end];	out[GMT_Y] = yy[edge[i].end];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[edge[i].end];
-					GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);
+				for (i = 0; i < n; i++) {
+					for (j = start[i]; j < start[i+1]; j++) {
+						sprintf (record, "Edge %" PRIu64 "-%" PRIu64, i, end[j]);
+						GMT_Put_Record (API, GMT_WRITE_SEGMENT_HEADER, record);
+						p = inc * i;
+						out[GMT_X] = xx[p];	out[GMT_Y] = yy[p];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[p];
+						GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);
+						p = inc * end[j];
+						out[GMT_X] = xx[p];	out[GMT_Y] = yy[p];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[p];
+						GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);
+					}
 				}
-				gmt_M_free (GMT, edge);
+				gmt_M_free (GMT, end);
+				gmt_M_free (GMT, start);
 			}
 		}
 		else if (Ctrl->S.active)  {	/* Write triangle polygons */
 			gmt_set_segmentheader (GMT, GMT_OUT, true);
 		for (i = ij = 0; i < np; i++, ij += 3) {
-				sprintf (record, "Polygon %d-%d-%d -Z%" PRIu64, link[ij], link[ij+1], link[ij+2], i);
+				sprintf (record, "Polygon %" PRIu64 "-%" PRIu64 "-%" PRIu64 " -Z%" PRIu64, link[ij], link[ij+1], link[ij+2], i);
 				GMT_Put_Record (API, GMT_WRITE_SEGMENT_HEADER, record);
 				for (k = 0; k < 3; k++) {	/* Three vertices */
-					out[GMT_X] = xx[link[ij+k]];	out[GMT_Y] = yy[link[ij+k]];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[link[ij+k]];
+					p = inc * link[ij+k];
+					out[GMT_X] = xx[p];	out[GMT_Y] = yy[p];	if (triplets[GMT_OUT]) out[GMT_Z] = zz[p];
 					GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);	/* Write this to output */
 				}
 			}
@@ -672,32 +3767,20 @@ int GMT_triangulate2 (void *V_API, int mode, void *args) {
 		else if (Ctrl->N.active) {	/* Write table of indices */
 			/* Set output format to regular float */
 			gmt_set_cartesian (GMT, GMT_OUT);	/* Since output is no longer lon/lat */
-			GMT->current.io.col_type[GMT_OUT][GMT_Z] = GMT_IS_FLOAT;
+			for (k = GMT_Z; k < n_output; k++) GMT->current.io.col_type[GMT_OUT][k] = GMT_IS_FLOAT;
 			for (i = ij = 0; i < np; i++, ij += 3) {
 				for (k = 0; k < 3; k++) out[k] = (double)link[ij+k];
+				if (Ctrl->N.neighbors) for (k = 0; k < 3; k++) out[k+3] = (neighbor[ij+k] == UINT64_MAX) ? -1.0 : (double)neighbor[ij+k];
 				GMT_Put_Record (API, GMT_WRITE_DOUBLE, out);	/* Write this to output */
 			}
 		}
 		if (GMT_End_IO (API, GMT_OUT, 0) != GMT_NOERROR) {	/* Disables further data output */
-			Return (API->error);
+			Free_Return (API->error);
 		}
 	}
 
-	gmt_M_free (GMT, xx);
-	gmt_M_free (GMT, yy);
-	if (triplets[GMT_IN]) gmt_M_free (GMT, zz);
-	//CURVE
-	if (quadruplets[GMT_IN]){
-		gmt_M_free (GMT, hh);
-		gmt_M_free (GMT, vv);
-	}
-	if (quintuplets[GMT_IN])
-	{
-		gmt_M_free (GMT, zz);
-		gmt_M_free (GMT, hh);
-		gmt_M_free (GMT, vv);
-	}
-	if (!Ctrl->Q.active) gmt_delaunay_free (GMT, &link);
+	free_input (GMT, &In);
+	free_link (GMT, &Tin, &Weights, &link, &neighbor);
 	GMT_Report (API, GMT_MSG_VERBOSE, "Done!\n");
 
 	Return (GMT_NOERROR);